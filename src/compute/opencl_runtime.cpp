@@ -226,9 +226,21 @@ struct OpenCLRuntime::Impl {
     bool molecules_ping = true;
     int width = 0;
     int height = 0;
+    std::vector<float> staging;
 
     std::string device_info;
 
+    // Host-Felder sind zeilenweise gepolstert, die Device-Puffer dicht.
+    const float *pack(const GridField &field) {
+        staging.resize(field.cell_count());
+        field.copy_to(staging.data());
+        return staging.data();
+    }
+    float *unpack_target(const GridField &field) {
+        staging.resize(field.cell_count());
+        return staging.data();
+    }
+
     void release_buffers() {
         if (phero_food_a) {
             OCL_CALL(clReleaseMemObject)(phero_food_a);
@@ -459,17 +471,17 @@ bool OpenCLRuntime::init_fields(const GridField &phero_food,
     impl->danger_ping = true;
     impl->molecules_ping = true;
 
-    err = OCL_CALL(clEnqueueWriteBuffer)(impl->queue, impl->phero_food_a, CL_TRUE, 0, bytes, phero_food.data.data(), 0, nullptr, nullptr);
+    err = OCL_CALL(clEnqueueWriteBuffer)(impl->queue, impl->phero_food_a, CL_TRUE, 0, bytes, impl->pack(phero_food), 0, nullptr, nullptr);
     if (err != CL_SUCCESS) {
         error = std::string("clEnqueueWriteBuffer phero_food failed: ") + cl_err_to_string(err);
         return false;
     }
-    err = OCL_CALL(clEnqueueWriteBuffer)(impl->queue, impl->phero_danger_a, CL_TRUE, 0, bytes, phero_danger.data.data(), 0, nullptr, nullptr);
+    err = OCL_CALL(clEnqueueWriteBuffer)(impl->queue, impl->phero_danger_a, CL_TRUE, 0, bytes, impl->pack(phero_danger), 0, nullptr, nullptr);
     if (err != CL_SUCCESS) {
         error = std::string("clEnqueueWriteBuffer phero_danger failed: ") + cl_err_to_string(err);
         return false;
     }
-    err = OCL_CALL(clEnqueueWriteBuffer)(impl->queue, impl->molecules_a, CL_TRUE, 0, bytes, molecules.data.data(), 0, nullptr, nullptr);
+    err = OCL_CALL(clEnqueueWriteBuffer)(impl->queue, impl->molecules_a, CL_TRUE, 0, bytes, impl->pack(molecules), 0, nullptr, nullptr);
     if (err != CL_SUCCESS) {
         error = std::string("clEnqueueWriteBuffer molecules failed: ") + cl_err_to_string(err);
         return false;
@@ -489,17 +501,17 @@ bool OpenCLRuntime::upload_fields(const GridField &phero_food,
     cl_mem food_current = impl->food_ping ? impl->phero_food_a : impl->phero_food_b;
     cl_mem danger_current = impl->danger_ping ? impl->phero_danger_a : impl->phero_danger_b;
     cl_mem m_current = impl->molecules_ping ? impl->molecules_a : impl->molecules_b;
-    cl_int err = OCL_CALL(clEnqueueWriteBuffer)(impl->queue, food_current, CL_TRUE, 0, bytes, phero_food.data.data(), 0, nullptr, nullptr);
+    cl_int err = OCL_CALL(clEnqueueWriteBuffer)(impl->queue, food_current, CL_TRUE, 0, bytes, impl->pack(phero_food), 0, nullptr, nullptr);
     if (err != CL_SUCCESS) {
         error = std::string("clEnqueueWriteBuffer phero_food failed: ") + cl_err_to_string(err);
         return false;
     }
-    err = OCL_CALL(clEnqueueWriteBuffer)(impl->queue, danger_current, CL_TRUE, 0, bytes, phero_danger.data.data(), 0, nullptr, nullptr);
+    err = OCL_CALL(clEnqueueWriteBuffer)(impl->queue, danger_current, CL_TRUE, 0, bytes, impl->pack(phero_danger), 0, nullptr, nullptr);
     if (err != CL_SUCCESS) {
         error = std::string("clEnqueueWriteBuffer phero_danger failed: ") + cl_err_to_string(err);
         return false;
     }
-    err = OCL_CALL(clEnqueueWriteBuffer)(impl->queue, m_current, CL_TRUE, 0, bytes, molecules.data.data(), 0, nullptr, nullptr);
+    err = OCL_CALL(clEnqueueWriteBuffer)(impl->queue, m_current, CL_TRUE, 0, bytes, impl->pack(molecules), 0, nullptr, nullptr);
     if (err != CL_SUCCESS) {
         error = std::string("clEnqueueWriteBuffer molecules failed: ") + cl_err_to_string(err);
         return false;
@@ -575,21 +587,24 @@ bool OpenCLRuntime::copyback(GridField &phero_food, GridField &phero_danger, Gri
     cl_mem food_current = impl->food_ping ? impl->phero_food_a : impl->phero_food_b;
     cl_mem danger_current = impl->danger_ping ? impl->phero_danger_a : impl->phero_danger_b;
     cl_mem m_current = impl->molecules_ping ? impl->molecules_a : impl->molecules_b;
-    cl_int err = OCL_CALL(clEnqueueReadBuffer)(impl->queue, food_current, CL_TRUE, 0, bytes, phero_food.data.data(), 0, nullptr, nullptr);
+    cl_int err = OCL_CALL(clEnqueueReadBuffer)(impl->queue, food_current, CL_TRUE, 0, bytes, impl->unpack_target(phero_food), 0, nullptr, nullptr);
     if (err != CL_SUCCESS) {
         error = std::string("clEnqueueReadBuffer phero_food failed: ") + cl_err_to_string(err);
         return false;
     }
-    err = OCL_CALL(clEnqueueReadBuffer)(impl->queue, danger_current, CL_TRUE, 0, bytes, phero_danger.data.data(), 0, nullptr, nullptr);
+    phero_food.copy_from(impl->staging.data());
+    err = OCL_CALL(clEnqueueReadBuffer)(impl->queue, danger_current, CL_TRUE, 0, bytes, impl->unpack_target(phero_danger), 0, nullptr, nullptr);
     if (err != CL_SUCCESS) {
         error = std::string("clEnqueueReadBuffer phero_danger failed: ") + cl_err_to_string(err);
         return false;
     }
-    err = OCL_CALL(clEnqueueReadBuffer)(impl->queue, m_current, CL_TRUE, 0, bytes, molecules.data.data(), 0, nullptr, nullptr);
+    phero_danger.copy_from(impl->staging.data());
+    err = OCL_CALL(clEnqueueReadBuffer)(impl->queue, m_current, CL_TRUE, 0, bytes, impl->unpack_target(molecules), 0, nullptr, nullptr);
     if (err != CL_SUCCESS) {
         error = std::string("clEnqueueReadBuffer molecules failed: ") + cl_err_to_string(err);
         return false;
     }
+    molecules.copy_from(impl->staging.data());
     return true;
 }
 
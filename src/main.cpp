@@ -10,6 +10,8 @@
 #include "compute/opencl_loader.h"
 #include "compute/opencl_runtime.h"
 #include "sim/agent.h"
+#include "sim/agent_soa.h"
+#include "sim/alloc_debug.h"
 #include "sim/dna_memory.h"
 #include "sim/environment.h"
 #include "sim/fields.h"
@@ -18,6 +20,9 @@
 #include "sim/params.h"
 #include "sim/report.h"
 #include "sim/rng.h"
+#include "sim/spawn.h"
+#include "sim/thread_pool.h"
+#include "sim/world_update.h"
 
 namespace {
 struct CliOptions {
@@ -25,6 +30,8 @@ struct CliOptions {
     bool height_set = false;
     SimParams params;
     uint32_t seed = 42;
+    int threads = 1;
+    FieldPrecision field_precision = FieldPrecision::Float32;
     std::string resources_path;
     std::string pheromone_path;
     std::string molecules_path;
@@ -140,18 +147,6 @@ std::array<SpeciesProfile, 4> default_species_profiles() {
     return profiles;
 }
 
-int pick_species(Rng &rng, const std::array<float, 4> &fracs) {
-    float r = rng.uniform(0.0f, 1.0f);
-    float accum = 0.0f;
-    for (int i = 0; i < 4; ++i) {
-        accum += fracs[i];
-        if (r <= accum) {
-            return i;
-        }
-    }
-    return 3;
-}
-
 void print_help() {
     std::cout << "micro_swarm Optionen:\n"
               << "  --width N        Rasterbreite\n"
@@ -160,10 +155,13 @@ void print_help() {
               << "  --agents N       Anzahl Agenten\n"
               << "  --steps N        Simulationsschritte\n"
               << "  --seed N         RNG-Seed\n"
+              << "  --threads N      Worker-Threads fuer Feldkernel (0=alle Kerne)\n"
+              << "  --field-precision fp32|fp16  Speicherformat Pheromon/Molekuele/Mycel\n"
               << "  --resources CSV  Startwerte Ressourcenfeld\n"
               << "  --pheromone CSV  Startwerte Pheromonfeld\n"
               << "  --molecules CSV  Startwerte Molekuelfeld\n"
               << "  --resource-regen F  Ressourcen-Regeneration\n"
+              << "  --resource-lazy-regen  Regeneration erst beim Lesen einer Kachel nachholen\n"
               << "  --mycel-growth F     Mycel-Wachstumsrate\n"
               << "  --mycel-decay F      Mycel-Decay\n"
               << "  --mycel-transport F  Mycel-Transport\n"
@@ -174,6 +172,10 @@ void print_help() {
               << "  --phero-danger-deposit F   Pheromon Danger Deposit\n"
               << "  --danger-delta-threshold F Danger Delta Schwelle\n"
               << "  --danger-bounce-deposit F  Danger Deposit bei Bounce\n"
+              << "  --sense-lod-radius F       Ab diesem Sensorradius grobe Feldstufen abtasten (0=aus)\n"
+              << "  --agent-parallel           Agentenphase parallel (reproduzierbar, aber andere Ergebnisse)\n"
+              << "  --agent-fast-steering      Richtungen als Binaerwinkel, cos/sin aus Tabelle\n"
+              << "  --agent-sort-every N       Agenten alle N Schritte nach Morton-Code sortieren (0=aus)\n"
               << "  --dump-every N   Dump-Intervall (0=aus)\n"
               << "  --dump-dir PATH  Dump-Verzeichnis\n"
               << "  --dump-prefix N  Dump-Dateiprefix\n"
@@ -291,6 +293,18 @@ bool parse_cli(int argc, char **argv, CliOptions &opts) {
             opts.evo_enable = true;
             continue;
         }
+        if (arg == "--resource-lazy-regen") {
+            opts.params.resource_lazy_regen = true;
+            continue;
+        }
+        if (arg == "--agent-parallel") {
+            opts.params.agent_parallel = true;
+            continue;
+        }
+        if (arg == "--agent-fast-steering") {
+            opts.params.agent_fast_steering = true;
+            continue;
+        }
         if (arg == "--stress-block-rect") {
             if (i + 4 >= argc) {
                 std::cerr << "Fehlender Wert fuer " << arg << "\n";
@@ -406,6 +420,21 @@ bool parse_cli(int argc, char **argv, CliOptions &opts) {
                 std::cerr << "Ungueltiger Wert fuer " << arg << "\n";
                 return false;
             }
+        } else if (arg == "--threads") {
+            if (!parse_int(value, opts.threads) || opts.threads < 0) {
+                std::cerr << "Ungueltiger Wert fuer " << arg << "\n";
+                return false;
+            }
+        } else if (arg == "--field-precision") {
+            const std::string precision = value;
+            if (precision == "fp32") {
+                opts.field_precision = FieldPrecision::Float32;
+            } else if (precision == "fp16") {
+                opts.field_precision = FieldPrecision::Float16;
+            } else {
+                std::cerr << "Ungueltiger Wert fuer " << arg << " (fp32|fp16)\n";
+                return false;
+            }
         } else if (arg == "--resources") {
             opts.resources_path = value;
         } else if (arg == "--pheromone") {
@@ -417,6 +446,16 @@ bool parse_cli(int argc, char **argv, CliOptions &opts) {
                 std::cerr << "Ungueltiger Wert fuer " << arg << "\n";
                 return false;
             }
+        } else if (arg == "--sense-lod-radius") {
+            if (!parse_float(value, opts.params.agent_sense_lod_radius) || opts.params.agent_sense_lod_radius < 0.0f) {
+                std::cerr << "Ungueltiger Wert fuer " << arg << "\n";
+                return false;
+            }
+        } else if (arg == "--agent-sort-every") {
+            if (!parse_int(value, opts.params.agent_sort_interval) || opts.params.agent_sort_interval < 0) {
+                std::cerr << "Ungueltiger Wert fuer " << arg << "\n";
+                return false;
+            }
         } else if (arg == "--mycel-growth") {
             if (!parse_float(value, opts.params.mycel_growth)) {
                 std::cerr << "Ungueltiger Wert fuer " << arg << "\n";
@@ -700,7 +739,10 @@ int main(int argc, char **argv) {
 
     Environment env(params.width, params.height);
     if (!resources_data.values.empty()) {
-        env.resources.data = resources_data.values;
+        if (!env.resources.assign(resources_data.values)) {
+            std::cerr << "resources: Groesse passt nicht zu den anderen CSV-Feldern\n";
+            return 1;
+        }
     } else {
         env.seed_resources(rng);
     }
@@ -709,11 +751,16 @@ int main(int argc, char **argv) {
     GridField phero_danger(params.width, params.height, 0.0f);
     GridField molecules(params.width, params.height, 0.0f);
     MycelNetwork mycel(params.width, params.height);
-    if (!pheromone_data.values.empty()) {
-        phero_food.data = pheromone_data.values;
+    if (!pheromone_data.values.empty() && !phero_food.assign(pheromone_data.values)) {
+        std::cerr << "pheromone: Groesse passt nicht zu den anderen CSV-Feldern\n";
+        return 1;
+    }
+    if (!molecules_data.values.empty() && !molecules.assign(molecules_data.values)) {
+        std::cerr << "molecules: Groesse passt nicht zu den anderen CSV-Feldern\n";
+        return 1;
     }
-    if (!molecules_data.values.empty()) {
-        molecules.data = molecules_data.values;
+    for (GridField *field : {&phero_food, &phero_danger, &molecules, &mycel.density}) {
+        field->set_precision(opts.field_precision);
     }
 
     std::array<DNAMemory, 4> dna_species;
@@ -725,83 +772,29 @@ int main(int argc, char **argv) {
     evo.exploration_delta = opts.evo_exploration_delta;
     evo.fitness_window = opts.evo_fitness_window;
     evo.age_decay = opts.evo_age_decay;
-    std::vector<Agent> agents;
+    AgentSoA agents;
     agents.reserve(params.agent_count);
 
-    auto random_genome = [&]() -> Genome {
-        Genome g;
-        g.sense_gain = rng.uniform(0.6f, 1.4f);
-        g.pheromone_gain = rng.uniform(0.6f, 1.4f);
-        g.exploration_bias = rng.uniform(0.2f, 0.8f);
-        return g;
-    };
-
-    auto apply_role_mutation = [&](Genome &g, const SpeciesProfile &profile) {
-        float sigma = evo.mutation_sigma * profile.mutation_sigma_mul;
-        float delta = evo.exploration_delta * profile.exploration_delta_mul;
-        if (sigma > 0.0f) {
-            g.sense_gain *= rng.uniform(1.0f - sigma, 1.0f + sigma);
-            g.pheromone_gain *= rng.uniform(1.0f - sigma, 1.0f + sigma);
-        }
-        if (delta > 0.0f) {
-            g.exploration_bias += rng.uniform(-delta, delta);
-        }
-        g.sense_gain = std::min(3.0f, std::max(0.2f, g.sense_gain));
-        g.pheromone_gain = std::min(3.0f, std::max(0.2f, g.pheromone_gain));
-        g.exploration_bias = std::min(1.0f, std::max(0.0f, g.exploration_bias));
-    };
-
-    auto sample_genome = [&](int species) -> Genome {
-        const SpeciesProfile &profile = opts.species_profiles[species];
-        bool use_dna = rng.uniform(0.0f, 1.0f) < profile.dna_binding;
-        Genome g;
-        if (use_dna) {
-            if (opts.evo_enable && !dna_global.entries.empty() && rng.uniform(0.0f, 1.0f) < opts.global_spawn_frac) {
-                g = dna_global.sample(rng, params, evo);
-            } else {
-                g = dna_species[species].sample(rng, params, evo);
-            }
-        } else {
-            g = random_genome();
-        }
-        if (opts.evo_enable) {
-            apply_role_mutation(g, profile);
-        }
-        return g;
-    };
-
-    const float global_epsilon = 1e-6f;
-    auto maybe_add_global = [&](const Genome &genome, float fitness) {
-        if (!opts.evo_enable) {
-            return;
-        }
-        if (params.dna_global_capacity <= 0) {
-            return;
-        }
-        if (dna_global.entries.size() < static_cast<size_t>(params.dna_global_capacity)) {
-            dna_global.add(params, genome, fitness, evo, params.dna_global_capacity);
-            return;
-        }
-        float worst = dna_global.entries.back().fitness;
-        if (fitness > worst + global_epsilon) {
-            dna_global.add(params, genome, fitness, evo, params.dna_global_capacity);
-        }
-    };
+    Spawner spawner;
+    spawner.params = &params;
+    spawner.evo = &evo;
+    spawner.profiles = opts.species_profiles.data();
+    spawner.species_fracs = &opts.species_fracs;
+    spawner.global_spawn_frac = opts.global_spawn_frac;
 
+    spawner.prepare(dna_species, dna_global);
     for (int i = 0; i < params.agent_count; ++i) {
-        Agent agent;
-        agent.x = static_cast<float>(rng.uniform_int(0, params.width - 1));
-        agent.y = static_cast<float>(rng.uniform_int(0, params.height - 1));
-        agent.heading = rng.uniform(0.0f, 6.283185307f);
-        agent.energy = rng.uniform(0.2f, 0.6f);
-        agent.species = pick_species(rng, opts.species_fracs);
-        agent.genome = sample_genome(agent.species);
-        agents.push_back(agent);
+        agents.push_back(spawner.spawn(rng, 0.6f));
     }
 
     FieldParams pheromone_params{params.pheromone_evaporation, params.pheromone_diffusion};
     FieldParams molecule_params{params.molecule_evaporation, params.molecule_diffusion};
 
+    ThreadPool thread_pool(opts.threads);
+    if (thread_pool.threads() > 1) {
+        std::cout << "[threads] field kernels on " << thread_pool.threads() << " threads\n";
+    }
+
     OpenCLRuntime ocl_runtime;
     bool ocl_active = false;
     if (opts.ocl_enable) {
@@ -837,9 +830,7 @@ int main(int argc, char **argv) {
         FieldParams fp{0.02f, 0.15f};
         FieldParams fm{0.35f, 0.25f};
         for (int i = 0; i < 5; ++i) {
-            diffuse_and_evaporate(cpu_pf, fp);
-            diffuse_and_evaporate(cpu_pd, fp);
-            diffuse_and_evaporate(cpu_m, fm);
+            diffuse_and_evaporate_fused(cpu_pf, fp, cpu_pd, fp, cpu_m, fm);
         }
 
         std::string error;
@@ -855,14 +846,16 @@ int main(int argc, char **argv) {
         }
         double mean_diff = 0.0;
         double max_abs = 0.0;
-        for (size_t i = 0; i < pf.data.size(); ++i) {
-            double d1 = std::abs(static_cast<double>(pf.data[i]) - cpu_pf.data[i]);
-            double d2 = std::abs(static_cast<double>(pd.data[i]) - cpu_pd.data[i]);
-            mean_diff += d1 + d2;
-            if (d1 > max_abs) max_abs = d1;
-            if (d2 > max_abs) max_abs = d2;
+        for (int y = 0; y < pf.height; ++y) {
+            for (int x = 0; x < pf.width; ++x) {
+                double d1 = std::abs(static_cast<double>(pf.at(x, y)) - cpu_pf.at(x, y));
+                double d2 = std::abs(static_cast<double>(pd.at(x, y)) - cpu_pd.at(x, y));
+                mean_diff += d1 + d2;
+                if (d1 > max_abs) max_abs = d1;
+                if (d2 > max_abs) max_abs = d2;
+            }
         }
-        mean_diff /= static_cast<double>(pf.data.size() * 2);
+        mean_diff /= static_cast<double>(pf.cell_count() * 2);
         std::cout << "[OpenCL] self-test mean_diff=" << mean_diff << " max_abs=" << max_abs << "\n";
         if (max_abs > 1e-3) {
             std::cerr << "[OpenCL] self-test too large diff, fallback to CPU\n";
@@ -905,10 +898,11 @@ int main(int argc, char **argv) {
         name << opts.dump_prefix << "_step" << std::setw(6) << std::setfill('0') << step;
         std::string base = name.str();
 
+        env.materialize_all();
         std::string error;
         auto dump_one = [&](const std::string &suffix, const GridField &field) -> bool {
             std::filesystem::path path = std::filesystem::path(opts.dump_dir) / (base + suffix);
-            if (!save_grid_csv(path.string(), field.width, field.height, field.data, error)) {
+            if (!save_grid_csv(path.string(), field.width, field.height, field.to_vector(), error)) {
                 std::cerr << error << "\n";
                 return false;
             }
@@ -927,6 +921,34 @@ int main(int argc, char **argv) {
     Rng stress_rng(opts.stress_seed);
     std::vector<SystemMetrics> system_metrics;
     system_metrics.reserve(static_cast<size_t>(params.steps));
+    uint64_t steady_allocs = 0;
+    int steady_alloc_steps = 0;
+
+    // Grobe Feldstufen fuer grosse Sensorradien (--sense-lod-radius), einmal pro Schritt aktualisiert.
+    const bool use_lod = params.agent_sense_lod_radius > 0.0f && !agents.empty();
+    std::array<FieldPyramid, 5> pyramids;
+    const SenseLod lod{&pyramids[0], &pyramids[1], &pyramids[2], &pyramids[3], &pyramids[4]};
+    AgentParallelScratch parallel_scratch;
+    AgentSortScratch sort_scratch;
+
+    // DNA-Kandidaten und Tote eines Schritts, in Agentenreihenfolge; die Pools werden erst nach der
+    // Agentenphase in einem Zug aktualisiert.
+    StepStaging staging;
+    staging.candidates.reserve(agents.size());
+    staging.dead.reserve(agents.size());
+    std::vector<StepStaging> staging_chunks;
+
+    // Ohne Agenten liest zwischen zwei Dumps niemand Gefahren-Pheromon und Molekuele;
+    // diese Schritte werden gesammelt und zeitlich geblockt nachgerechnet.
+    const bool defer_field_steps = agents.empty() && !ocl_active &&
+                                   !(opts.stress_enable && opts.stress_pheromone_noise > 0.0f);
+    int deferred_steps = 0;
+    auto flush_deferred_fields = [&]() {
+        if (deferred_steps <= 0) return;
+        diffuse_and_evaporate_steps(phero_danger, pheromone_params, deferred_steps, &thread_pool);
+        diffuse_and_evaporate_steps(molecules, molecule_params, deferred_steps, &thread_pool);
+        deferred_steps = 0;
+    };
 
     for (int step = 0; step < params.steps; ++step) {
         bool dump_step = (opts.dump_every > 0 && step % opts.dump_every == 0);
@@ -942,30 +964,47 @@ int main(int argc, char **argv) {
                 env.apply_block_rect(opts.stress_block_x, opts.stress_block_y, opts.stress_block_w, opts.stress_block_h);
             }
             if (opts.stress_shift_set) {
-                env.shift_hotspots(opts.stress_shift_dx, opts.stress_shift_dy);
+                env.shift_hotspots(opts.stress_shift_dx, opts.stress_shift_dy, &thread_pool);
             }
             stress_applied = true;
             std::cout << "[stress] applied at step=" << step << "\n";
         }
+        if (dump_step) {
+            flush_deferred_fields();
+        }
         if (!dump_fields(step)) {
             return 1;
         }
-        for (auto &agent : agents) {
-            const SpeciesProfile &profile = opts.species_profiles[agent.species];
-            agent.step(rng, params, opts.evo_enable ? opts.evo_fitness_window : 0, profile, phero_food, phero_danger, molecules, env.resources, mycel.density);
-            if (opts.evo_enable) {
-                if (agent.energy > opts.evo_min_energy_to_store) {
-                    dna_species[agent.species].add(params, agent.genome, agent.fitness_value, evo, params.dna_capacity);
-                    maybe_add_global(agent.genome, agent.fitness_value);
-                    agent.energy *= 0.6f;
-                }
-            } else {
-                if (agent.energy > 1.2f) {
-                    dna_species[agent.species].add(params, agent.genome, agent.energy, evo, params.dna_capacity);
-                    agent.energy *= 0.6f;
-                }
+        const uint64_t allocs_before = debug_heap_allocations();
+        if (params.agent_sort_interval > 0 && step % params.agent_sort_interval == 0) {
+            sort_agents_morton(agents, sort_scratch);
+        }
+        staging.clear();
+        if (use_lod) {
+            env.materialize_all();
+            pyramids[0].update(phero_food, &thread_pool);
+            pyramids[1].update(phero_danger, &thread_pool);
+            pyramids[2].update(molecules, &thread_pool);
+            pyramids[3].update(env.resources, &thread_pool);
+            pyramids[4].update(mycel.density, &thread_pool);
+        }
+        const int fitness_window = opts.evo_enable ? opts.evo_fitness_window : 0;
+        if (params.agent_parallel) {
+            step_agents_parallel(agents, opts.seed, static_cast<uint32_t>(step), params, fitness_window,
+                                 opts.species_profiles.data(), phero_food, phero_danger, molecules, env, mycel.density,
+                                 use_lod ? &lod : nullptr, &thread_pool, parallel_scratch);
+            stage_agents_parallel(agents, opts.evo_enable, opts.evo_min_energy_to_store, &thread_pool, staging_chunks,
+                                  staging);
+        } else {
+            for (size_t begin = 0; begin < agents.size(); begin += AgentSoA::kBatch) {
+                const size_t end = std::min(agents.size(), begin + AgentSoA::kBatch);
+                step_agent_batch(agents, begin, end, opts.seed, static_cast<uint32_t>(step), params, fitness_window,
+                                 opts.species_profiles.data(), phero_food, phero_danger, molecules, env, mycel.density,
+                                 use_lod ? &lod : nullptr);
+                stage_agents(agents, begin, end, opts.evo_enable, opts.evo_min_energy_to_store, staging);
             }
         }
+        merge_staged_dna(staging, params, evo, dna_species, dna_global);
 
         if (ocl_active) {
             std::string ocl_error;
@@ -975,63 +1014,69 @@ int main(int argc, char **argv) {
             }
         }
 
+        const bool pheromone_noise = opts.stress_enable && stress_applied && opts.stress_pheromone_noise > 0.0f;
+        bool world_updated = false;
         if (ocl_active) {
             bool do_copyback = (!opts.ocl_no_copyback) || dump_step;
             std::string ocl_error;
             if (!ocl_runtime.step_diffuse(pheromone_params, molecule_params, do_copyback, phero_food, phero_danger, molecules, ocl_error)) {
                 std::cerr << "[OpenCL] diffuse failed, fallback to CPU: " << ocl_error << "\n";
                 ocl_active = false;
-                diffuse_and_evaporate(phero_food, pheromone_params);
-                diffuse_and_evaporate(phero_danger, pheromone_params);
-                diffuse_and_evaporate(molecules, molecule_params);
+                diffuse_and_evaporate_fused(phero_food, pheromone_params, phero_danger, pheromone_params, molecules, molecule_params, &thread_pool);
+            }
+        } else if (!pheromone_noise) {
+            // Diffusion, Mycel und Regeneration in einem Durchlauf; aufgeschobene Felder bleiben aussen vor.
+            world_update_fused(params, phero_food, defer_field_steps ? nullptr : &phero_danger,
+                               defer_field_steps ? nullptr : &molecules, mycel, env, &thread_pool);
+            world_updated = true;
+            if (defer_field_steps) {
+                deferred_steps += 1;
             }
         } else {
-            diffuse_and_evaporate(phero_food, pheromone_params);
-            diffuse_and_evaporate(phero_danger, pheromone_params);
-            diffuse_and_evaporate(molecules, molecule_params);
+            diffuse_and_evaporate_fused(phero_food, pheromone_params, phero_danger, pheromone_params, molecules, molecule_params, &thread_pool);
         }
 
-        if (opts.stress_enable && stress_applied && opts.stress_pheromone_noise > 0.0f) {
-            for (float &v : phero_food.data) {
-                v += stress_rng.uniform(0.0f, opts.stress_pheromone_noise);
-                if (v < 0.0f) v = 0.0f;
-            }
-            for (float &v : phero_danger.data) {
-                v += stress_rng.uniform(0.0f, opts.stress_pheromone_noise);
-                if (v < 0.0f) v = 0.0f;
+        if (pheromone_noise) {
+            for (GridField *field : {&phero_food, &phero_danger}) {
+                for (int y = 0; y < field->height; ++y) {
+                    for (int x = 0; x < field->width; ++x) {
+                        float v = field->get(x, y) + stress_rng.uniform(0.0f, opts.stress_pheromone_noise);
+                        if (v < 0.0f) v = 0.0f;
+                        field->set(x, y, v);
+                    }
+                }
+                field->mark_all_active();
             }
         }
 
-        mycel.update(params, phero_food, env.resources);
-        env.regenerate(params);
+        if (!world_updated) {
+            mycel.update(params, phero_food, env, &thread_pool);
+            env.regenerate(params, &thread_pool);
+        }
         for (auto &pool : dna_species) {
             pool.decay(evo);
         }
         dna_global.decay(evo);
 
-        for (auto &agent : agents) {
-            if (agent.energy <= 0.05f) {
-                agent.x = static_cast<float>(rng.uniform_int(0, params.width - 1));
-                agent.y = static_cast<float>(rng.uniform_int(0, params.height - 1));
-                agent.heading = rng.uniform(0.0f, 6.283185307f);
-                agent.energy = rng.uniform(0.2f, 0.5f);
-                agent.last_energy = agent.energy;
-                agent.fitness_accum = 0.0f;
-                agent.fitness_ticks = 0;
-                agent.fitness_value = 0.0f;
-                agent.species = pick_species(rng, opts.species_fracs);
-                agent.genome = sample_genome(agent.species);
-            }
+        if (!staging.dead.empty()) {
+            spawner.prepare(dna_species, dna_global);
+            spawner.respawn(agents, staging.dead, opts.seed, static_cast<uint32_t>(step));
+        }
+        const uint64_t step_allocs = debug_heap_allocations() - allocs_before;
+        if (step > 0 && step_allocs > 0) {
+            steady_allocs += step_allocs;
+            steady_alloc_steps += 1;
         }
 
         float avg_energy = 0.0f;
         std::array<float, 4> energy_sum{0.0f, 0.0f, 0.0f, 0.0f};
         std::array<int, 4> energy_count{0, 0, 0, 0};
-        for (const auto &agent : agents) {
-            avg_energy += agent.energy;
-            if (agent.species >= 0 && agent.species < 4) {
-                energy_sum[agent.species] += agent.energy;
-                energy_count[agent.species] += 1;
+        for (size_t i = 0; i < agents.size(); ++i) {
+            avg_energy += agents.energy[i];
+            const int species = agents.species[i];
+            if (species >= 0 && species < 4) {
+                energy_sum[species] += agents.energy[i];
+                energy_count[species] += 1;
             }
         }
         avg_energy /= static_cast<float>(agents.size());
@@ -1055,10 +1100,12 @@ int main(int argc, char **argv) {
 
         if (step % 10 == 0) {
             float mycel_sum = 0.0f;
-            for (float v : mycel.density.data) {
-                mycel_sum += v;
+            for (int y = 0; y < mycel.density.height; ++y) {
+                for (int x = 0; x < mycel.density.width; ++x) {
+                    mycel_sum += mycel.density.get(x, y);
+                }
             }
-            float mycel_avg = mycel_sum / static_cast<float>(mycel.density.data.size());
+            float mycel_avg = mycel_sum / static_cast<float>(mycel.density.cell_count());
 
             std::cout << "step=" << step
                       << " avg_energy=" << avg_energy
@@ -1068,6 +1115,13 @@ int main(int argc, char **argv) {
         }
     }
 
+    flush_deferred_fields();
+
+#if MICRO_SWARM_DEBUG_ALLOC
+    std::cout << "[alloc] steady-state heap_allocs=" << steady_allocs
+              << " steps_with_allocs=" << steady_alloc_steps << "\n";
+#endif
+
     if (ocl_active && opts.ocl_no_copyback) {
         std::string ocl_error;
         if (!ocl_runtime.copyback(phero_food, phero_danger, molecules, ocl_error)) {
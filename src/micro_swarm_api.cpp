@@ -5,19 +5,26 @@
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
 
 #include "compute/opencl_runtime.h"
 #include "sim/agent.h"
+#include "sim/agent_index.h"
+#include "sim/agent_soa.h"
 #include "sim/dna_memory.h"
 #include "sim/environment.h"
 #include "sim/fields.h"
 #include "sim/io.h"
 #include "sim/mycel.h"
 #include "sim/params.h"
+#include "sim/pyramid.h"
 #include "sim/rng.h"
+#include "sim/spawn.h"
+#include "sim/thread_pool.h"
+#include "sim/world_update.h"
 
 namespace {
 struct MicroSwarmContext {
@@ -38,10 +45,20 @@ struct MicroSwarmContext {
     GridField phero_danger;
     GridField molecules;
     MycelNetwork mycel;
+    std::array<FieldPyramid, 6> pyramids;
+    FieldPrecision field_precision = FieldPrecision::Float32;
 
     std::array<DNAMemory, 4> dna_species;
     DNAMemory dna_global;
-    std::vector<Agent> agents;
+    AgentSoA agents;
+    AgentParallelScratch parallel_scratch;
+    AgentSortScratch sort_scratch;
+    StepStaging staging;
+    std::vector<StepStaging> staging_chunks;
+    AgentIndex agent_index;
+    bool agent_index_dirty = true;
+    GridField agent_density;
+    ThreadPool thread_pool;
 
     OpenCLRuntime ocl;
     bool ocl_active = false;
@@ -56,7 +73,8 @@ struct MicroSwarmContext {
           phero_food(0, 0, 0.0f),
           phero_danger(0, 0, 0.0f),
           molecules(0, 0, 0.0f),
-          mycel(0, 0) {}
+          mycel(0, 0),
+          agent_density(0, 0, 0.0f) {}
 };
 
 std::array<SpeciesProfile, 4> default_species_profiles() {
@@ -127,24 +145,6 @@ std::array<SpeciesProfile, 4> default_species_profiles() {
     return profiles;
 }
 
-int pick_species(Rng &rng, const std::array<float, 4> &fracs) {
-    float r = rng.uniform(0.0f, 1.0f);
-    float accum = 0.0f;
-    for (int i = 0; i < 4; ++i) {
-        accum += fracs[i];
-        if (r <= accum) {
-            return i;
-        }
-    }
-    return 3;
-}
-
-void clamp_genome(Genome &g) {
-    g.sense_gain = std::min(3.0f, std::max(0.2f, g.sense_gain));
-    g.pheromone_gain = std::min(3.0f, std::max(0.2f, g.pheromone_gain));
-    g.exploration_bias = std::min(1.0f, std::max(0.0f, g.exploration_bias));
-}
-
 struct FieldStatsLocal {
     float min = 0.0f;
     float max = 0.0f;
@@ -197,72 +197,70 @@ FieldStatsLocal compute_entropy_stats(const std::vector<float> &values, int bins
     return stats;
 }
 
+const AgentIndex &ensure_agent_index(MicroSwarmContext *ctx) {
+    if (ctx->agent_index_dirty) {
+        ctx->agent_index.rebuild(ctx->agents, ctx->params.width, ctx->params.height);
+        ctx->agent_index_dirty = false;
+    }
+    return ctx->agent_index;
+}
+
+void slots_to_ids(const AgentSoA &agents, int *slots, int count) {
+    for (int k = 0; k < count; ++k) {
+        slots[k] = agents.id[slots[k]];
+    }
+}
+
 GridField *select_field(MicroSwarmContext *ctx, ms_field_kind kind) {
     switch (kind) {
-        case MS_FIELD_RESOURCES: return &ctx->env.resources;
+        case MS_FIELD_RESOURCES:
+            ctx->env.materialize_all();
+            return &ctx->env.resources;
         case MS_FIELD_PHEROMONE_FOOD: return &ctx->phero_food;
         case MS_FIELD_PHEROMONE_DANGER: return &ctx->phero_danger;
         case MS_FIELD_MOLECULES: return &ctx->molecules;
         case MS_FIELD_MYCEL: return &ctx->mycel.density;
+        case MS_FIELD_AGENT_DENSITY:
+            ensure_agent_index(ctx).density(ctx->agent_density);
+            return &ctx->agent_density;
         default: return nullptr;
     }
 }
 
+const FieldPyramid *update_pyramid(MicroSwarmContext *ctx, ms_field_kind kind) {
+    GridField *field = select_field(ctx, kind);
+    if (!field) return nullptr;
+    FieldPyramid &pyramid = ctx->pyramids[static_cast<size_t>(kind)];
+    pyramid.update(*field, &ctx->thread_pool);
+    return &pyramid;
+}
+
+Spawner make_spawner(MicroSwarmContext *ctx) {
+    Spawner spawner;
+    spawner.params = &ctx->params;
+    spawner.evo = &ctx->evo;
+    spawner.profiles = ctx->profiles.data();
+    spawner.species_fracs = &ctx->species_fracs;
+    spawner.global_spawn_frac = ctx->global_spawn_frac;
+    spawner.prepare(ctx->dna_species, ctx->dna_global);
+    return spawner;
+}
+
 void init_agents(MicroSwarmContext *ctx) {
     ctx->agents.clear();
+    ctx->agent_index_dirty = true;
     ctx->agents.reserve(ctx->params.agent_count);
-    auto random_genome = [&]() -> Genome {
-        Genome g;
-        g.sense_gain = ctx->rng.uniform(0.6f, 1.4f);
-        g.pheromone_gain = ctx->rng.uniform(0.6f, 1.4f);
-        g.exploration_bias = ctx->rng.uniform(0.2f, 0.8f);
-        return g;
-    };
-    auto apply_role_mutation = [&](Genome &g, const SpeciesProfile &profile) {
-        float sigma = ctx->evo.mutation_sigma * profile.mutation_sigma_mul;
-        float delta = ctx->evo.exploration_delta * profile.exploration_delta_mul;
-        if (sigma > 0.0f) {
-            g.sense_gain *= ctx->rng.uniform(1.0f - sigma, 1.0f + sigma);
-            g.pheromone_gain *= ctx->rng.uniform(1.0f - sigma, 1.0f + sigma);
-        }
-        if (delta > 0.0f) {
-            g.exploration_bias += ctx->rng.uniform(-delta, delta);
-        }
-        clamp_genome(g);
-    };
-    auto sample_genome = [&](int species) -> Genome {
-        const SpeciesProfile &profile = ctx->profiles[species];
-        bool use_dna = ctx->rng.uniform(0.0f, 1.0f) < profile.dna_binding;
-        Genome g;
-        if (use_dna) {
-            if (ctx->evo.enabled && !ctx->dna_global.entries.empty() &&
-                ctx->rng.uniform(0.0f, 1.0f) < ctx->global_spawn_frac) {
-                g = ctx->dna_global.sample(ctx->rng, ctx->params, ctx->evo);
-            } else {
-                g = ctx->dna_species[species].sample(ctx->rng, ctx->params, ctx->evo);
-            }
-        } else {
-            g = random_genome();
-        }
-        if (ctx->evo.enabled) {
-            apply_role_mutation(g, profile);
-        }
-        return g;
-    };
-
+    ctx->staging.candidates.reserve(ctx->params.agent_count);
+    ctx->staging.dead.reserve(ctx->params.agent_count);
+    Spawner spawner = make_spawner(ctx);
     for (int i = 0; i < ctx->params.agent_count; ++i) {
-        Agent agent;
-        agent.x = static_cast<float>(ctx->rng.uniform_int(0, ctx->params.width - 1));
-        agent.y = static_cast<float>(ctx->rng.uniform_int(0, ctx->params.height - 1));
-        agent.heading = ctx->rng.uniform(0.0f, 6.283185307f);
-        agent.energy = ctx->rng.uniform(0.2f, 0.6f);
-        agent.last_energy = agent.energy;
-        agent.fitness_accum = 0.0f;
-        agent.fitness_ticks = 0;
-        agent.fitness_value = 0.0f;
-        agent.species = pick_species(ctx->rng, ctx->species_fracs);
-        agent.genome = sample_genome(agent.species);
-        ctx->agents.push_back(agent);
+        ctx->agents.push_back(spawner.spawn(ctx->rng, 0.6f));
+    }
+}
+
+void apply_field_precision(MicroSwarmContext *ctx) {
+    for (GridField *field : {&ctx->phero_food, &ctx->phero_danger, &ctx->molecules, &ctx->mycel.density}) {
+        field->set_precision(ctx->field_precision);
     }
 }
 
@@ -273,9 +271,11 @@ void init_fields(MicroSwarmContext *ctx) {
     ctx->phero_danger = GridField(ctx->params.width, ctx->params.height, 0.0f);
     ctx->molecules = GridField(ctx->params.width, ctx->params.height, 0.0f);
     ctx->mycel = MycelNetwork(ctx->params.width, ctx->params.height);
+    apply_field_precision(ctx);
 }
 
 bool ensure_host_fields(MicroSwarmContext *ctx) {
+    ctx->env.materialize_all();
     if (ctx->ocl_active && ctx->ocl_no_copyback) {
         std::string error;
         if (!ctx->ocl.copyback(ctx->phero_food, ctx->phero_danger, ctx->molecules, error)) {
@@ -283,7 +283,7 @@ bool ensure_host_fields(MicroSwarmContext *ctx) {
         }
     }
     return true;
-}
+}
 void step_once(MicroSwarmContext *ctx) {
     if (ctx->paused) {
         return;
@@ -291,36 +291,60 @@ void step_once(MicroSwarmContext *ctx) {
     FieldParams pheromone_params{ctx->params.pheromone_evaporation, ctx->params.pheromone_diffusion};
     FieldParams molecule_params{ctx->params.molecule_evaporation, ctx->params.molecule_diffusion};
 
-    for (auto &agent : ctx->agents) {
-        const SpeciesProfile &profile = ctx->profiles[agent.species];
-        agent.step(ctx->rng,
-                   ctx->params,
-                   ctx->evo.enabled ? ctx->evo.fitness_window : 0,
-                   profile,
-                   ctx->phero_food,
-                   ctx->phero_danger,
-                   ctx->molecules,
-                   ctx->env.resources,
-                   ctx->mycel.density);
-        if (ctx->evo.enabled) {
-            if (agent.energy > ctx->evo_min_energy_to_store) {
-                ctx->dna_species[agent.species].add(ctx->params, agent.genome, agent.fitness_value, ctx->evo, ctx->params.dna_capacity);
-                float eps = 1e-6f;
-                if (ctx->params.dna_global_capacity > 0) {
-                    if (ctx->dna_global.entries.size() < static_cast<size_t>(ctx->params.dna_global_capacity) ||
-                        agent.fitness_value > ctx->dna_global.entries.back().fitness + eps) {
-                        ctx->dna_global.add(ctx->params, agent.genome, agent.fitness_value, ctx->evo, ctx->params.dna_global_capacity);
-                    }
-                }
-                agent.energy *= 0.6f;
-            }
-        } else {
-            if (agent.energy > 1.2f) {
-                ctx->dna_species[agent.species].add(ctx->params, agent.genome, agent.energy, ctx->evo, ctx->params.dna_capacity);
-                agent.energy *= 0.6f;
-            }
+    if (ctx->params.agent_sort_interval > 0 && ctx->step_index % ctx->params.agent_sort_interval == 0) {
+        sort_agents_morton(ctx->agents, ctx->sort_scratch);
+    }
+
+    SenseLod lod;
+    const bool use_lod = ctx->params.agent_sense_lod_radius > 0.0f && !ctx->agents.empty();
+    if (use_lod) {
+        lod.phero_food = update_pyramid(ctx, MS_FIELD_PHEROMONE_FOOD);
+        lod.phero_danger = update_pyramid(ctx, MS_FIELD_PHEROMONE_DANGER);
+        lod.molecules = update_pyramid(ctx, MS_FIELD_MOLECULES);
+        lod.resources = update_pyramid(ctx, MS_FIELD_RESOURCES);
+        lod.mycel = update_pyramid(ctx, MS_FIELD_MYCEL);
+    }
+    AgentSoA &agents = ctx->agents;
+    ctx->staging.clear();
+    const int fitness_window = ctx->evo.enabled ? ctx->evo.fitness_window : 0;
+    if (ctx->params.agent_parallel) {
+        step_agents_parallel(agents,
+                             ctx->seed,
+                             static_cast<uint32_t>(ctx->step_index),
+                             ctx->params,
+                             fitness_window,
+                             ctx->profiles.data(),
+                             ctx->phero_food,
+                             ctx->phero_danger,
+                             ctx->molecules,
+                             ctx->env,
+                             ctx->mycel.density,
+                             use_lod ? &lod : nullptr,
+                             &ctx->thread_pool,
+                             ctx->parallel_scratch);
+        stage_agents_parallel(agents, ctx->evo.enabled, ctx->evo_min_energy_to_store, &ctx->thread_pool,
+                              ctx->staging_chunks, ctx->staging);
+    } else {
+        for (size_t begin = 0; begin < agents.size(); begin += AgentSoA::kBatch) {
+            const size_t end = std::min(agents.size(), begin + AgentSoA::kBatch);
+            step_agent_batch(agents,
+                             begin,
+                             end,
+                             ctx->seed,
+                             static_cast<uint32_t>(ctx->step_index),
+                             ctx->params,
+                             fitness_window,
+                             ctx->profiles.data(),
+                             ctx->phero_food,
+                             ctx->phero_danger,
+                             ctx->molecules,
+                             ctx->env,
+                             ctx->mycel.density,
+                             use_lod ? &lod : nullptr);
+            stage_agents(agents, begin, end, ctx->evo.enabled, ctx->evo_min_energy_to_store, ctx->staging);
         }
     }
+    merge_staged_dna(ctx->staging, ctx->params, ctx->evo, ctx->dna_species, ctx->dna_global);
 
     if (ctx->ocl_active) {
         std::string error;
@@ -334,76 +358,22 @@ void step_once(MicroSwarmContext *ctx) {
         std::string error;
         if (!ctx->ocl.step_diffuse(pheromone_params, molecule_params, do_copyback, ctx->phero_food, ctx->phero_danger, ctx->molecules, error)) {
             ctx->ocl_active = false;
-            diffuse_and_evaporate(ctx->phero_food, pheromone_params);
-            diffuse_and_evaporate(ctx->phero_danger, pheromone_params);
-            diffuse_and_evaporate(ctx->molecules, molecule_params);
+            diffuse_and_evaporate_fused(ctx->phero_food, pheromone_params, ctx->phero_danger, pheromone_params, ctx->molecules, molecule_params, &ctx->thread_pool);
         }
+        ctx->mycel.update(ctx->params, ctx->phero_food, ctx->env, &ctx->thread_pool);
+        ctx->env.regenerate(ctx->params, &ctx->thread_pool);
     } else {
-        diffuse_and_evaporate(ctx->phero_food, pheromone_params);
-        diffuse_and_evaporate(ctx->phero_danger, pheromone_params);
-        diffuse_and_evaporate(ctx->molecules, molecule_params);
+        world_update_fused(ctx->params, ctx->phero_food, &ctx->phero_danger, &ctx->molecules, ctx->mycel, ctx->env, &ctx->thread_pool);
     }
-
-    ctx->mycel.update(ctx->params, ctx->phero_food, ctx->env.resources);
-    ctx->env.regenerate(ctx->params);
     for (auto &pool : ctx->dna_species) {
         pool.decay(ctx->evo);
     }
     ctx->dna_global.decay(ctx->evo);
 
-    auto random_genome = [&]() -> Genome {
-        Genome g;
-        g.sense_gain = ctx->rng.uniform(0.6f, 1.4f);
-        g.pheromone_gain = ctx->rng.uniform(0.6f, 1.4f);
-        g.exploration_bias = ctx->rng.uniform(0.2f, 0.8f);
-        return g;
-    };
-    auto apply_role_mutation = [&](Genome &g, const SpeciesProfile &profile) {
-        float sigma = ctx->evo.mutation_sigma * profile.mutation_sigma_mul;
-        float delta = ctx->evo.exploration_delta * profile.exploration_delta_mul;
-        if (sigma > 0.0f) {
-            g.sense_gain *= ctx->rng.uniform(1.0f - sigma, 1.0f + sigma);
-            g.pheromone_gain *= ctx->rng.uniform(1.0f - sigma, 1.0f + sigma);
-        }
-        if (delta > 0.0f) {
-            g.exploration_bias += ctx->rng.uniform(-delta, delta);
-        }
-        clamp_genome(g);
-    };
-    auto sample_genome = [&](int species) -> Genome {
-        const SpeciesProfile &profile = ctx->profiles[species];
-        bool use_dna = ctx->rng.uniform(0.0f, 1.0f) < profile.dna_binding;
-        Genome g;
-        if (use_dna) {
-            if (ctx->evo.enabled && !ctx->dna_global.entries.empty() &&
-                ctx->rng.uniform(0.0f, 1.0f) < ctx->global_spawn_frac) {
-                g = ctx->dna_global.sample(ctx->rng, ctx->params, ctx->evo);
-            } else {
-                g = ctx->dna_species[species].sample(ctx->rng, ctx->params, ctx->evo);
-            }
-        } else {
-            g = random_genome();
-        }
-        if (ctx->evo.enabled) {
-            apply_role_mutation(g, profile);
-        }
-        return g;
-    };
-
-    for (auto &agent : ctx->agents) {
-        if (agent.energy <= 0.05f) {
-            agent.x = static_cast<float>(ctx->rng.uniform_int(0, ctx->params.width - 1));
-            agent.y = static_cast<float>(ctx->rng.uniform_int(0, ctx->params.height - 1));
-            agent.heading = ctx->rng.uniform(0.0f, 6.283185307f);
-            agent.energy = ctx->rng.uniform(0.2f, 0.5f);
-            agent.last_energy = agent.energy;
-            agent.fitness_accum = 0.0f;
-            agent.fitness_ticks = 0;
-            agent.fitness_value = 0.0f;
-            agent.species = pick_species(ctx->rng, ctx->species_fracs);
-            agent.genome = sample_genome(agent.species);
-        }
+    if (!ctx->staging.dead.empty()) {
+        make_spawner(ctx).respawn(agents, ctx->staging.dead, ctx->seed, static_cast<uint32_t>(ctx->step_index));
     }
+    ctx->agent_index_dirty = true;
     ctx->step_index += 1;
 }
 
@@ -481,33 +451,80 @@ void set_params_from_api(MicroSwarmContext *ctx, const ms_params_t &p) {
     ctx->evo.mutation_sigma = p.evo_mutation_sigma;
     ctx->evo.exploration_delta = p.evo_exploration_delta;
     ctx->evo.fitness_window = p.evo_fitness_window;
-    ctx->evo.age_decay = p.evo_age_decay;
+    // Auf [0, 1] begrenzt; Werte > 1 liessen fitness_scale ueberlaufen.
+    ctx->evo.age_decay = std::min(1.0f, std::max(0.0f, p.evo_age_decay));
     ctx->evo_min_energy_to_store = p.evo_min_energy_to_store;
     ctx->global_spawn_frac = p.global_spawn_frac;
 }
 
-} // namespace
-
-extern "C" {
-ms_handle_t *ms_create(const ms_config_t *cfg) {
-    uint32_t seed = 42;
-    if (cfg) {
-        seed = cfg->seed;
-    }
+MicroSwarmContext *create_context(const ms_params_t *p, uint32_t seed) {
     auto *ctx = new MicroSwarmContext(seed);
     ctx->profiles = default_species_profiles();
-    SimParams params;
-    EvoParams evo;
-    if (cfg) {
-        set_params_from_api(ctx, cfg->params);
+    if (p) {
+        set_params_from_api(ctx, *p);
     } else {
-        ctx->params = params;
-        ctx->evo = evo;
+        ctx->params = SimParams();
+        ctx->evo = EvoParams();
         ctx->global_spawn_frac = 0.15f;
     }
     init_fields(ctx);
     init_agents(ctx);
-    return reinterpret_cast<ms_handle_t *>(ctx);
+    return ctx;
+}
+
+// Inselmodell: unabhaengige Welten, je Insel ein Worker. Migration nur zwischen den Schrittbloecken,
+// wenn alle Inseln stehen; die Pools werden also nie gleichzeitig gelesen und geschrieben.
+struct MicroSwarmIslands {
+    std::vector<std::unique_ptr<MicroSwarmContext>> islands;
+    ThreadPool thread_pool;
+    int migrate_interval = 0;
+    int migrate_count = 0;
+    int steps_done = 0;
+    std::vector<std::vector<DNACandidate>> outbox;
+
+    explicit MicroSwarmIslands(int threads) : thread_pool(threads) {}
+};
+
+// Ring: die besten migrate_count Genome des globalen Pools jeder Insel gehen in den globalen Pool der
+// naechsten, sofern dort nicht schon vorhanden. Erst werden alle Auswanderer eingesammelt, dann eingefuegt.
+void migrate(MicroSwarmIslands *isl) {
+    const size_t count = isl->islands.size();
+    if (count < 2 || isl->migrate_count <= 0) {
+        return;
+    }
+    isl->outbox.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const DNAMemory &pool = isl->islands[i]->dna_global;
+        const size_t n = std::min(pool.entries.size(), static_cast<size_t>(isl->migrate_count));
+        isl->outbox[i].clear();
+        for (size_t k = 0; k < n; ++k) {
+            isl->outbox[i].push_back({pool.entries[k].genome, pool.fitness(pool.entries[k]), -1});
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        MicroSwarmContext *target = isl->islands[(i + 1) % count].get();
+        const int capacity = target->params.dna_global_capacity;
+        if (capacity <= 0) {
+            continue;
+        }
+        for (const DNACandidate &c : isl->outbox[i]) {
+            const auto &entries = target->dna_global.entries;
+            const bool known = std::any_of(entries.begin(), entries.end(), [&](const DNAEntry &e) {
+                return e.genome.sense_gain == c.genome.sense_gain && e.genome.pheromone_gain == c.genome.pheromone_gain &&
+                       e.genome.exploration_bias == c.genome.exploration_bias;
+            });
+            if (!known) {
+                target->dna_global.add(target->params, c.genome, c.fitness, capacity);
+            }
+        }
+    }
+}
+
+} // namespace
+
+extern "C" {
+ms_handle_t *ms_create(const ms_config_t *cfg) {
+    return reinterpret_cast<ms_handle_t *>(create_context(cfg ? &cfg->params : nullptr, cfg ? cfg->seed : 42));
 }
 
 void ms_destroy(ms_handle_t *h) {
@@ -530,8 +547,8 @@ void ms_reset(ms_handle_t *h, uint32_t seed) {
     ctx->seed = seed;
     ctx->rng = Rng(seed);
     ctx->step_index = 0;
-    for (auto &pool : ctx->dna_species) pool.entries.clear();
-    ctx->dna_global.entries.clear();
+    for (auto &pool : ctx->dna_species) pool.clear();
+    ctx->dna_global.clear();
     init_fields(ctx);
     init_agents(ctx);
 }
@@ -647,7 +664,7 @@ void ms_get_field_info(ms_handle_t *h, ms_field_kind kind, int *w, int *hgt) {
     }
     *w = field->width;
     *hgt = field->height;
-}
+}
 int ms_copy_field_out(ms_handle_t *h, ms_field_kind kind, float *dst, int dst_count) {
     if (!h || !dst) return 0;
     auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
@@ -656,18 +673,60 @@ int ms_copy_field_out(ms_handle_t *h, ms_field_kind kind, float *dst, int dst_co
     if (!field) return 0;
     int count = field->width * field->height;
     if (dst_count < count) return 0;
-    std::copy(field->data.begin(), field->data.end(), dst);
+    field->copy_to(dst);
+    return count;
+}
+
+int ms_get_field_levels(ms_handle_t *h, ms_field_kind kind) {
+    if (!h) return 0;
+    auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
+    GridField *field = select_field(ctx, kind);
+    if (!field) return 0;
+    int levels = 1;
+    for (int w = field->width, hgt = field->height; w > 1 || hgt > 1; w = (w + 1) / 2, hgt = (hgt + 1) / 2) {
+        ++levels;
+    }
+    return levels;
+}
+
+void ms_get_field_level_info(ms_handle_t *h, ms_field_kind kind, int level, int *w, int *hgt) {
+    if (!h || !w || !hgt) return;
+    *w = 0;
+    *hgt = 0;
+    if (level < 0 || level >= ms_get_field_levels(h, kind)) return;
+    auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
+    GridField *field = select_field(ctx, kind);
+    *w = field->width;
+    *hgt = field->height;
+    for (int k = 0; k < level; ++k) {
+        *w = (*w + 1) / 2;
+        *hgt = (*hgt + 1) / 2;
+    }
+}
+
+int ms_copy_field_out_level(ms_handle_t *h, ms_field_kind kind, int level, float *dst, int dst_count) {
+    if (!h || !dst) return 0;
+    if (level == 0) return ms_copy_field_out(h, kind, dst, dst_count);
+    if (level < 0 || level >= ms_get_field_levels(h, kind)) return 0;
+    auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
+    if (!ensure_host_fields(ctx)) return 0;
+    const FieldPyramid *pyramid = update_pyramid(ctx, kind);
+    if (!pyramid) return 0;
+    const GridField &field = pyramid->level(level);
+    int count = field.width * field.height;
+    if (dst_count < count) return 0;
+    field.copy_to(dst);
     return count;
 }
 
 int ms_copy_field_in(ms_handle_t *h, ms_field_kind kind, const float *src, int src_count) {
-    if (!h || !src) return 0;
+    if (!h || !src || kind == MS_FIELD_AGENT_DENSITY) return 0;
     auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
     GridField *field = select_field(ctx, kind);
     if (!field) return 0;
     int count = field->width * field->height;
     if (src_count < count) return 0;
-    std::copy(src, src + count, field->data.begin());
+    field->copy_from(src);
     if (ctx->ocl_active) {
         std::string error;
         ctx->ocl.upload_fields(ctx->phero_food, ctx->phero_danger, ctx->molecules, error);
@@ -676,7 +735,7 @@ int ms_copy_field_in(ms_handle_t *h, ms_field_kind kind, const float *src, int s
 }
 
 void ms_clear_field(ms_handle_t *h, ms_field_kind kind, float value) {
-    if (!h) return;
+    if (!h || kind == MS_FIELD_AGENT_DENSITY) return;
     auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
     GridField *field = select_field(ctx, kind);
     if (!field) return;
@@ -686,9 +745,48 @@ void ms_clear_field(ms_handle_t *h, ms_field_kind kind, float value) {
         ctx->ocl.upload_fields(ctx->phero_food, ctx->phero_danger, ctx->molecules, error);
     }
 }
+int ms_fast_forward_field(ms_handle_t *h, ms_field_kind kind, int steps) {
+    if (!h || steps <= 0) return 0;
+    auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
+    FieldParams params{};
+    if (kind == MS_FIELD_PHEROMONE_FOOD || kind == MS_FIELD_PHEROMONE_DANGER) {
+        params = FieldParams{ctx->params.pheromone_evaporation, ctx->params.pheromone_diffusion};
+    } else if (kind == MS_FIELD_MOLECULES) {
+        params = FieldParams{ctx->params.molecule_evaporation, ctx->params.molecule_diffusion};
+    } else {
+        return 0;
+    }
+    if (!ensure_host_fields(ctx)) return 0;
+    GridField *field = select_field(ctx, kind);
+    if (!field) return 0;
+    diffuse_and_evaporate_steps(*field, params, steps, &ctx->thread_pool);
+    if (ctx->ocl_active) {
+        std::string error;
+        ctx->ocl.upload_fields(ctx->phero_food, ctx->phero_danger, ctx->molecules, error);
+    }
+    return steps;
+}
+
+void ms_set_field_precision(ms_handle_t *h, ms_field_precision precision) {
+    if (!h) return;
+    auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
+    if (!ensure_host_fields(ctx)) return;
+    ctx->field_precision = precision == MS_PRECISION_FLOAT16 ? FieldPrecision::Float16 : FieldPrecision::Float32;
+    apply_field_precision(ctx);
+    if (ctx->ocl_active) {
+        std::string error;
+        ctx->ocl.upload_fields(ctx->phero_food, ctx->phero_danger, ctx->molecules, error);
+    }
+}
+
+ms_field_precision ms_get_field_precision(ms_handle_t *h) {
+    if (!h) return MS_PRECISION_FLOAT32;
+    auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
+    return ctx->field_precision == FieldPrecision::Float16 ? MS_PRECISION_FLOAT16 : MS_PRECISION_FLOAT32;
+}
 
 int ms_load_field_csv(ms_handle_t *h, ms_field_kind kind, const char *path) {
-    if (!h || !path) return 0;
+    if (!h || !path || kind == MS_FIELD_AGENT_DENSITY) return 0;
     auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
     GridData data;
     std::string error;
@@ -700,7 +798,7 @@ int ms_load_field_csv(ms_handle_t *h, ms_field_kind kind, const char *path) {
     if (data.width != field->width || data.height != field->height) {
         return 0;
     }
-    field->data = data.values;
+    field->copy_from(data.values.data());
     if (ctx->ocl_active) {
         ctx->ocl.upload_fields(ctx->phero_food, ctx->phero_danger, ctx->molecules, error);
     }
@@ -714,7 +812,7 @@ int ms_save_field_csv(ms_handle_t *h, ms_field_kind kind, const char *path) {
     GridField *field = select_field(ctx, kind);
     if (!field) return 0;
     std::string error;
-    if (!save_grid_csv(path, field->width, field->height, field->data, error)) {
+    if (!save_grid_csv(path, field->width, field->height, field->to_vector(), error)) {
         return 0;
     }
     return 1;
@@ -730,16 +828,17 @@ int ms_get_agents(ms_handle_t *h, ms_agent_t *out, int max_agents) {
     if (!h || !out || max_agents <= 0) return 0;
     auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
     int count = std::min(max_agents, static_cast<int>(ctx->agents.size()));
-    for (int i = 0; i < count; ++i) {
-        const auto &a = ctx->agents[i];
-        out[i].x = a.x;
-        out[i].y = a.y;
-        out[i].heading = a.heading;
-        out[i].energy = a.energy;
-        out[i].species = a.species;
-        out[i].sense_gain = a.genome.sense_gain;
-        out[i].pheromone_gain = a.genome.pheromone_gain;
-        out[i].exploration_bias = a.genome.exploration_bias;
+    const AgentSoA &agents = ctx->agents;
+    for (int id = 0; id < count; ++id) {
+        const int i = agents.slot_of_id[id];
+        out[id].x = agents.x[i];
+        out[id].y = agents.y[i];
+        out[id].heading = agents.heading[i];
+        out[id].energy = agents.energy[i];
+        out[id].species = agents.species[i];
+        out[id].sense_gain = agents.sense_gain[i];
+        out[id].pheromone_gain = agents.pheromone_gain[i];
+        out[id].exploration_bias = agents.exploration_bias[i];
     }
     return count;
 }
@@ -767,13 +866,14 @@ void ms_set_agents(ms_handle_t *h, const ms_agent_t *agents, int count) {
         ctx->agents.push_back(a);
     }
     ctx->params.agent_count = static_cast<int>(ctx->agents.size());
+    ctx->agent_index_dirty = true;
 }
 
 void ms_kill_agent(ms_handle_t *h, int agent_id) {
     if (!h) return;
     auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
     if (agent_id < 0 || agent_id >= static_cast<int>(ctx->agents.size())) return;
-    ctx->agents[agent_id].energy = 0.0f;
+    ctx->agents.energy[ctx->agents.slot_of_id[agent_id]] = 0.0f;
 }
 
 void ms_spawn_agent(ms_handle_t *h, const ms_agent_t *agent) {
@@ -795,7 +895,25 @@ void ms_spawn_agent(ms_handle_t *h, const ms_agent_t *agent) {
     clamp_genome(a.genome);
     ctx->agents.push_back(a);
     ctx->params.agent_count = static_cast<int>(ctx->agents.size());
-}
+    ctx->agent_index_dirty = true;
+}
+
+int ms_query_agents_rect(ms_handle_t *h, float x0, float y0, float x1, float y1, int *out_ids, int max_ids) {
+    if (!h || (!out_ids && max_ids > 0)) return 0;
+    auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
+    const int found = ensure_agent_index(ctx).query_rect(ctx->agents, x0, y0, x1, y1, out_ids, std::max(max_ids, 0));
+    slots_to_ids(ctx->agents, out_ids, std::min(found, max_ids));
+    return found;
+}
+
+int ms_query_agents_radius(ms_handle_t *h, float x, float y, float radius, int *out_ids, int max_ids) {
+    if (!h || (!out_ids && max_ids > 0)) return 0;
+    auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
+    const int found = ensure_agent_index(ctx).query_radius(ctx->agents, x, y, radius, out_ids, std::max(max_ids, 0));
+    slots_to_ids(ctx->agents, out_ids, std::min(found, max_ids));
+    return found;
+}
+
 void ms_get_dna_sizes(ms_handle_t *h, int out_species[4], int *out_global) {
     if (!h || !out_species || !out_global) return;
     auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
@@ -831,9 +949,9 @@ void ms_clear_dna_pools(ms_handle_t *h) {
     if (!h) return;
     auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
     for (auto &pool : ctx->dna_species) {
-        pool.entries.clear();
+        pool.clear();
     }
-    ctx->dna_global.entries.clear();
+    ctx->dna_global.clear();
 }
 
 int ms_export_dna_csv(ms_handle_t *h, const char *path) {
@@ -844,12 +962,12 @@ int ms_export_dna_csv(ms_handle_t *h, const char *path) {
     out << "pool,species,fitness,sense_gain,pheromone_gain,exploration_bias\n";
     for (int s = 0; s < 4; ++s) {
         for (const auto &e : ctx->dna_species[s].entries) {
-            out << "species," << s << "," << e.fitness << ","
+            out << "species," << s << "," << ctx->dna_species[s].fitness(e) << ","
                 << e.genome.sense_gain << "," << e.genome.pheromone_gain << "," << e.genome.exploration_bias << "\n";
         }
     }
     for (const auto &e : ctx->dna_global.entries) {
-        out << "global,-1," << e.fitness << ","
+        out << "global,-1," << ctx->dna_global.fitness(e) << ","
             << e.genome.sense_gain << "," << e.genome.pheromone_gain << "," << e.genome.exploration_bias << "\n";
     }
     return 1;
@@ -880,10 +998,10 @@ int ms_import_dna_csv(ms_handle_t *h, const char *path) {
         g.exploration_bias = std::stof(eb_str);
         clamp_genome(g);
         if (pool == "global") {
-            ctx->dna_global.add(ctx->params, g, fitness, ctx->evo, ctx->params.dna_global_capacity);
+            ctx->dna_global.add(ctx->params, g, fitness, ctx->params.dna_global_capacity);
         } else {
             if (species >= 0 && species < 4) {
-                ctx->dna_species[species].add(ctx->params, g, fitness, ctx->evo, ctx->params.dna_capacity);
+                ctx->dna_species[species].add(ctx->params, g, fitness, ctx->params.dna_capacity);
             }
         }
     }
@@ -898,11 +1016,12 @@ void ms_get_system_metrics(ms_handle_t *h, ms_metrics_t *out) {
     float avg_energy = 0.0f;
     std::array<float, 4> sums{0.0f, 0.0f, 0.0f, 0.0f};
     std::array<int, 4> counts{0, 0, 0, 0};
-    for (const auto &a : ctx->agents) {
-        avg_energy += a.energy;
-        if (a.species >= 0 && a.species < 4) {
-            sums[a.species] += a.energy;
-            counts[a.species] += 1;
+    const AgentSoA &agents = ctx->agents;
+    for (size_t i = 0; i < agents.size(); ++i) {
+        avg_energy += agents.energy[i];
+        if (agents.species[i] >= 0 && agents.species[i] < 4) {
+            sums[agents.species[i]] += agents.energy[i];
+            counts[agents.species[i]] += 1;
         }
     }
     avg_energy = ctx->agents.empty() ? 0.0f : avg_energy / static_cast<float>(ctx->agents.size());
@@ -923,12 +1042,12 @@ void ms_get_energy_stats(ms_handle_t *h, float *avg, float *min, float *max) {
         return;
     }
     float sum = 0.0f;
-    float minv = ctx->agents.front().energy;
-    float maxv = ctx->agents.front().energy;
-    for (const auto &a : ctx->agents) {
-        sum += a.energy;
-        minv = std::min(minv, a.energy);
-        maxv = std::max(maxv, a.energy);
+    float minv = ctx->agents.energy.front();
+    float maxv = ctx->agents.energy.front();
+    for (float energy : ctx->agents.energy) {
+        sum += energy;
+        minv = std::min(minv, energy);
+        maxv = std::max(maxv, energy);
     }
     *avg = sum / static_cast<float>(ctx->agents.size());
     *min = minv;
@@ -940,10 +1059,11 @@ void ms_get_energy_by_species(ms_handle_t *h, float out[4]) {
     auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
     std::array<float, 4> sums{0.0f, 0.0f, 0.0f, 0.0f};
     std::array<int, 4> counts{0, 0, 0, 0};
-    for (const auto &a : ctx->agents) {
-        if (a.species >= 0 && a.species < 4) {
-            sums[a.species] += a.energy;
-            counts[a.species] += 1;
+    const AgentSoA &agents = ctx->agents;
+    for (size_t i = 0; i < agents.size(); ++i) {
+        if (agents.species[i] >= 0 && agents.species[i] < 4) {
+            sums[agents.species[i]] += agents.energy[i];
+            counts[agents.species[i]] += 1;
         }
     }
     for (int i = 0; i < 4; ++i) {
@@ -964,7 +1084,7 @@ void ms_get_entropy_metrics(ms_handle_t *h, ms_entropy_t *out) {
         &ctx->mycel.density
     };
     for (int i = 0; i < 5; ++i) {
-        FieldStatsLocal stats = compute_entropy_stats(fields[i]->data, bins);
+        FieldStatsLocal stats = compute_entropy_stats(fields[i]->to_vector(), bins);
         out->entropy[i] = stats.entropy;
         out->norm_entropy[i] = stats.norm_entropy;
         out->p95[i] = stats.p95;
@@ -974,24 +1094,27 @@ void ms_get_entropy_metrics(ms_handle_t *h, ms_entropy_t *out) {
 void ms_get_mycel_stats(ms_handle_t *h, ms_mycel_stats_t *out) {
     if (!h || !out) return;
     auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
-    const auto &values = ctx->mycel.density.data;
-    if (values.empty()) {
+    const GridField &density = ctx->mycel.density;
+    if (density.cell_count() == 0) {
         out->min_val = 0.0f;
         out->max_val = 0.0f;
         out->mean = 0.0f;
         return;
     }
-    float minv = values.front();
-    float maxv = values.front();
+    float minv = density.get(0, 0);
+    float maxv = minv;
     double sum = 0.0;
-    for (float v : values) {
-        minv = std::min(minv, v);
-        maxv = std::max(maxv, v);
-        sum += v;
+    for (int y = 0; y < density.height; ++y) {
+        for (int x = 0; x < density.width; ++x) {
+            const float v = density.get(x, y);
+            minv = std::min(minv, v);
+            maxv = std::max(maxv, v);
+            sum += v;
+        }
     }
     out->min_val = minv;
     out->max_val = maxv;
-    out->mean = static_cast<float>(sum / static_cast<double>(values.size()));
+    out->mean = static_cast<float>(sum / static_cast<double>(density.cell_count()));
 }
 
 void ms_ocl_enable(ms_handle_t *h, int enable) {
@@ -1050,6 +1173,129 @@ int ms_is_gpu_active(ms_handle_t *h) {
     return ctx->ocl_active ? 1 : 0;
 }
 
+void ms_set_threads(ms_handle_t *h, int threads) {
+    if (!h) return;
+    auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
+    ctx->thread_pool.set_threads(threads);
+}
+
+int ms_get_threads(ms_handle_t *h) {
+    if (!h) return 0;
+    auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
+    return ctx->thread_pool.threads();
+}
+
+void ms_set_agent_sense_lod_radius(ms_handle_t *h, float radius) {
+    if (!h) return;
+    auto *ctx = reinterpret_cast<MicroSwarmContext *>(h);
+    ctx->params.agent_sense_lod_radius = radius > 0.0f ? radius : 0.0f;
+}
+
+float ms_get_agent_sense_lod_radius(ms_handle_t *h) {
+    if (!h) return 0.0f;
+    return reinterpret_cast<MicroSwarmContext *>(h)->params.agent_sense_lod_radius;
+}
+
+void ms_set_resource_lazy_regen(ms_handle_t *h, int enable) {
+    if (!h) return;
+    reinterpret_cast<MicroSwarmContext *>(h)->params.resource_lazy_regen = enable != 0;
+}
+
+int ms_get_resource_lazy_regen(ms_handle_t *h) {
+    if (!h) return 0;
+    return reinterpret_cast<MicroSwarmContext *>(h)->params.resource_lazy_regen ? 1 : 0;
+}
+
+void ms_set_agent_parallel(ms_handle_t *h, int enable) {
+    if (!h) return;
+    reinterpret_cast<MicroSwarmContext *>(h)->params.agent_parallel = enable != 0;
+}
+
+int ms_get_agent_parallel(ms_handle_t *h) {
+    if (!h) return 0;
+    return reinterpret_cast<MicroSwarmContext *>(h)->params.agent_parallel ? 1 : 0;
+}
+
+void ms_set_agent_fast_steering(ms_handle_t *h, int enable) {
+    if (!h) return;
+    reinterpret_cast<MicroSwarmContext *>(h)->params.agent_fast_steering = enable != 0;
+}
+
+int ms_get_agent_fast_steering(ms_handle_t *h) {
+    if (!h) return 0;
+    return reinterpret_cast<MicroSwarmContext *>(h)->params.agent_fast_steering ? 1 : 0;
+}
+
+void ms_set_agent_sort_interval(ms_handle_t *h, int interval) {
+    if (!h) return;
+    reinterpret_cast<MicroSwarmContext *>(h)->params.agent_sort_interval = std::max(0, interval);
+}
+
+int ms_get_agent_sort_interval(ms_handle_t *h) {
+    if (!h) return 0;
+    return reinterpret_cast<MicroSwarmContext *>(h)->params.agent_sort_interval;
+}
+
+ms_islands_t *ms_islands_create(const ms_config_t *cfg, int island_count, int threads) {
+    if (island_count <= 0) return nullptr;
+    const uint32_t seed = cfg ? cfg->seed : 42;
+    auto *isl = new MicroSwarmIslands(threads);
+    for (int i = 0; i < island_count; ++i) {
+        isl->islands.emplace_back(create_context(cfg ? &cfg->params : nullptr, seed + static_cast<uint32_t>(i)));
+    }
+    return reinterpret_cast<ms_islands_t *>(isl);
+}
+
+void ms_islands_destroy(ms_islands_t *islands) {
+    if (!islands) return;
+    delete reinterpret_cast<MicroSwarmIslands *>(islands);
+}
+
+int ms_islands_count(ms_islands_t *islands) {
+    if (!islands) return 0;
+    return static_cast<int>(reinterpret_cast<MicroSwarmIslands *>(islands)->islands.size());
+}
+
+ms_handle_t *ms_islands_get(ms_islands_t *islands, int index) {
+    if (!islands) return nullptr;
+    auto *isl = reinterpret_cast<MicroSwarmIslands *>(islands);
+    if (index < 0 || index >= static_cast<int>(isl->islands.size())) return nullptr;
+    return reinterpret_cast<ms_handle_t *>(isl->islands[index].get());
+}
+
+void ms_islands_set_migration(ms_islands_t *islands, int interval, int count) {
+    if (!islands) return;
+    auto *isl = reinterpret_cast<MicroSwarmIslands *>(islands);
+    isl->migrate_interval = std::max(0, interval);
+    isl->migrate_count = std::max(0, count);
+}
+
+int ms_islands_step(ms_islands_t *islands, int steps) {
+    if (!islands || steps <= 0) return 0;
+    auto *isl = reinterpret_cast<MicroSwarmIslands *>(islands);
+    const int count = static_cast<int>(isl->islands.size());
+    int done = 0;
+    while (done < steps) {
+        int block = steps - done;
+        if (isl->migrate_interval > 0) {
+            block = std::min(block, isl->migrate_interval - isl->steps_done % isl->migrate_interval);
+        }
+        parallel_for(&isl->thread_pool, 0, count, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                for (int k = 0; k < block; ++k) {
+                    step_once(isl->islands[i].get());
+                }
+            }
+        });
+        done += block;
+        isl->steps_done += block;
+        if (isl->migrate_interval > 0 && isl->steps_done % isl->migrate_interval == 0) {
+            migrate(isl);
+        }
+    }
+    return steps;
+}
+
 void ms_get_api_version(int *major, int *minor, int *patch) {
     if (major) *major = MS_API_VERSION_MAJOR;
     if (minor) *minor = MS_API_VERSION_MINOR;
@@ -17,19 +17,26 @@ extern "C" {
 #endif
 
 #define MS_API_VERSION_MAJOR 1
-#define MS_API_VERSION_MINOR 0
-#define MS_API_VERSION_PATCH 0
+#define MS_API_VERSION_MINOR 10
+#define MS_API_VERSION_PATCH 1
 
 typedef struct ms_handle_t ms_handle_t;
+typedef struct ms_islands_t ms_islands_t;
 
 typedef enum ms_field_kind {
     MS_FIELD_RESOURCES = 0,
     MS_FIELD_PHEROMONE_FOOD = 1,
     MS_FIELD_PHEROMONE_DANGER = 2,
     MS_FIELD_MOLECULES = 3,
-    MS_FIELD_MYCEL = 4
+    MS_FIELD_MYCEL = 4,
+    MS_FIELD_AGENT_DENSITY = 5
 } ms_field_kind;
 
+typedef enum ms_field_precision {
+    MS_PRECISION_FLOAT32 = 0,
+    MS_PRECISION_FLOAT16 = 1
+} ms_field_precision;
+
 typedef struct ms_params_t {
     int width;
     int height;
@@ -150,8 +157,14 @@ MICRO_SWARM_API void ms_get_species_fracs(ms_handle_t *h, float out[4]);
 
 MICRO_SWARM_API void ms_get_field_info(ms_handle_t *h, ms_field_kind kind, int *w, int *hgt);
 MICRO_SWARM_API int ms_copy_field_out(ms_handle_t *h, ms_field_kind kind, float *dst, int dst_count);
+MICRO_SWARM_API int ms_get_field_levels(ms_handle_t *h, ms_field_kind kind);
+MICRO_SWARM_API void ms_get_field_level_info(ms_handle_t *h, ms_field_kind kind, int level, int *w, int *hgt);
+MICRO_SWARM_API int ms_copy_field_out_level(ms_handle_t *h, ms_field_kind kind, int level, float *dst, int dst_count);
 MICRO_SWARM_API int ms_copy_field_in(ms_handle_t *h, ms_field_kind kind, const float *src, int src_count);
 MICRO_SWARM_API void ms_clear_field(ms_handle_t *h, ms_field_kind kind, float value);
+MICRO_SWARM_API int ms_fast_forward_field(ms_handle_t *h, ms_field_kind kind, int steps);
+MICRO_SWARM_API void ms_set_field_precision(ms_handle_t *h, ms_field_precision precision);
+MICRO_SWARM_API ms_field_precision ms_get_field_precision(ms_handle_t *h);
 
 MICRO_SWARM_API int ms_load_field_csv(ms_handle_t *h, ms_field_kind kind, const char *path);
 MICRO_SWARM_API int ms_save_field_csv(ms_handle_t *h, ms_field_kind kind, const char *path);
@@ -161,6 +174,8 @@ MICRO_SWARM_API int ms_get_agents(ms_handle_t *h, ms_agent_t *out, int max_agent
 MICRO_SWARM_API void ms_set_agents(ms_handle_t *h, const ms_agent_t *agents, int count);
 MICRO_SWARM_API void ms_kill_agent(ms_handle_t *h, int agent_id);
 MICRO_SWARM_API void ms_spawn_agent(ms_handle_t *h, const ms_agent_t *agent);
+MICRO_SWARM_API int ms_query_agents_rect(ms_handle_t *h, float x0, float y0, float x1, float y1, int *out_ids, int max_ids);
+MICRO_SWARM_API int ms_query_agents_radius(ms_handle_t *h, float x, float y, float radius, int *out_ids, int max_ids);
 
 MICRO_SWARM_API void ms_get_dna_sizes(ms_handle_t *h, int out_species[4], int *out_global);
 MICRO_SWARM_API void ms_get_dna_capacity(ms_handle_t *h, int *species_cap, int *global_cap);
@@ -181,6 +196,27 @@ MICRO_SWARM_API void ms_ocl_print_devices(void);
 MICRO_SWARM_API void ms_ocl_set_no_copyback(ms_handle_t *h, int enable);
 MICRO_SWARM_API int ms_is_gpu_active(ms_handle_t *h);
 
+MICRO_SWARM_API void ms_set_threads(ms_handle_t *h, int threads);
+MICRO_SWARM_API int ms_get_threads(ms_handle_t *h);
+
+MICRO_SWARM_API void ms_set_agent_sense_lod_radius(ms_handle_t *h, float radius);
+MICRO_SWARM_API float ms_get_agent_sense_lod_radius(ms_handle_t *h);
+MICRO_SWARM_API void ms_set_resource_lazy_regen(ms_handle_t *h, int enable);
+MICRO_SWARM_API int ms_get_resource_lazy_regen(ms_handle_t *h);
+MICRO_SWARM_API void ms_set_agent_parallel(ms_handle_t *h, int enable);
+MICRO_SWARM_API int ms_get_agent_parallel(ms_handle_t *h);
+MICRO_SWARM_API void ms_set_agent_fast_steering(ms_handle_t *h, int enable);
+MICRO_SWARM_API int ms_get_agent_fast_steering(ms_handle_t *h);
+MICRO_SWARM_API void ms_set_agent_sort_interval(ms_handle_t *h, int interval);
+MICRO_SWARM_API int ms_get_agent_sort_interval(ms_handle_t *h);
+
+MICRO_SWARM_API ms_islands_t *ms_islands_create(const ms_config_t *cfg, int island_count, int threads);
+MICRO_SWARM_API void ms_islands_destroy(ms_islands_t *islands);
+MICRO_SWARM_API int ms_islands_count(ms_islands_t *islands);
+MICRO_SWARM_API ms_handle_t *ms_islands_get(ms_islands_t *islands, int index);
+MICRO_SWARM_API void ms_islands_set_migration(ms_islands_t *islands, int interval, int count);
+MICRO_SWARM_API int ms_islands_step(ms_islands_t *islands, int steps);
+
 MICRO_SWARM_API void ms_get_api_version(int *major, int *minor, int *patch);
 
 #ifdef __cplusplus
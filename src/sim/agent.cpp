@@ -1,7 +1,10 @@
 #include "agent.h"
 
+#include <algorithm>
 #include <cmath>
 
+#include "steering.h"
+
 namespace {
 float wrap_angle(float a) {
     const float two_pi = 6.283185307f;
@@ -10,16 +13,83 @@ float wrap_angle(float a) {
     return a;
 }
 
+// Koordinaten ausserhalb landen auf der Geisterzelle (Wert 0), ohne Verzweigung.
 float sample_field(const GridField &field, float fx, float fy) {
-    int x = static_cast<int>(fx);
-    int y = static_cast<int>(fy);
-    if (x < 0 || y < 0 || x >= field.width || y >= field.height) {
-        return 0.0f;
-    }
-    return field.at(x, y);
+    int x = std::min(std::max(static_cast<int>(fx), -1), field.width);
+    int y = std::min(std::max(static_cast<int>(fy), -1), field.height);
+    return field.get(x, y);
 }
 } // namespace
 
+void sensor_probes(const SimParams &params, float x, float y, float heading, float sensor, float angles[3],
+                   float px[3], float py[3]) {
+    if (params.agent_fast_steering) {
+        const BinaryAngle center = to_binary_angle(heading);
+        const BinaryAngle probes[3] = {static_cast<BinaryAngle>(center - kSensorOffsetAngle), center,
+                                       static_cast<BinaryAngle>(center + kSensorOffsetAngle)};
+        for (int i = 0; i < 3; ++i) {
+            const SinCos &dir = sin_cos(probes[i]);
+            angles[i] = from_binary_angle(probes[i]);
+            px[i] = x + dir.c * sensor;
+            py[i] = y + dir.s * sensor;
+        }
+        return;
+    }
+    angles[0] = heading - 0.6f;
+    angles[1] = heading;
+    angles[2] = heading + 0.6f;
+    for (int i = 0; i < 3; ++i) {
+        px[i] = x + std::cos(angles[i]) * sensor;
+        py[i] = y + std::sin(angles[i]) * sensor;
+    }
+}
+
+int sense_level(const SimParams &params, float sensor, const SenseLod *lod) {
+    int level = 0;
+    if (lod && params.agent_sense_lod_radius > 0.0f) {
+        const int max_level = lod->phero_food->level_count() - 1;
+        float reach = params.agent_sense_lod_radius;
+        while (sensor >= reach && level < max_level) {
+            ++level;
+            reach *= 2.0f;
+        }
+    }
+    return level;
+}
+
+float sample_sense_field(const GridField &field, const FieldPyramid *pyramid, int level, float fx, float fy) {
+    if (level == 0) {
+        return sample_field(field, fx, fy);
+    }
+    const float level_scale = 1.0f / static_cast<float>(1 << level);
+    return sample_field(pyramid->level(level), fx * level_scale, fy * level_scale);
+}
+
+void Agent::sense(const SimParams &params,
+                  const GridField &phero_food,
+                  const GridField &phero_danger,
+                  const GridField &molecules,
+                  const GridField &resources,
+                  const GridField &mycel,
+                  const SenseLod *lod,
+                  AgentSense &out) const {
+    const float sensor = params.agent_sense_radius * genome.sense_gain;
+    const int level = sense_level(params, sensor, lod);
+    const SenseLod pyramids = lod ? *lod : SenseLod{};
+    float px[3];
+    float py[3];
+    sensor_probes(params, x, y, heading, sensor, out.angles, px, py);
+    for (int i = 0; i < 3; ++i) {
+        const float nx = px[i];
+        const float ny = py[i];
+        out.phero_food[i] = sample_sense_field(phero_food, pyramids.phero_food, level, nx, ny);
+        out.phero_danger[i] = sample_sense_field(phero_danger, pyramids.phero_danger, level, nx, ny);
+        out.resources[i] = sample_sense_field(resources, pyramids.resources, level, nx, ny);
+        out.molecules[i] = sample_sense_field(molecules, pyramids.molecules, level, nx, ny);
+        out.mycel[i] = sample_sense_field(mycel, pyramids.mycel, level, nx, ny);
+    }
+}
+
 void Agent::step(Rng &rng,
                  const SimParams &params,
                  int fitness_window,
@@ -28,26 +98,24 @@ void Agent::step(Rng &rng,
                  GridField &phero_danger,
                  GridField &molecules,
                  GridField &resources,
-                 const GridField &mycel) {
-    last_energy = energy;
-    const float sensor = params.agent_sense_radius * genome.sense_gain;
+                 const GridField &mycel,
+                 const SenseLod *lod) {
+    AgentSense sensed;
+    sense(params, phero_food, phero_danger, molecules, resources, mycel, lod, sensed);
+    act(rng, params, fitness_window, profile, sensed, phero_food, phero_danger, molecules, resources, mycel);
+}
+
+bool Agent::steer(Rng &rng, const SimParams &params, const SpeciesProfile &profile, const AgentSense &sensed,
+                  int width, int height) {
     const float turn = params.agent_random_turn * profile.exploration_mul;
 
-    float angles[3] = {
-        heading - 0.6f,
-        heading,
-        heading + 0.6f
-    };
     float weights[3] = {};
-
     for (int i = 0; i < 3; ++i) {
-        float nx = x + std::cos(angles[i]) * sensor;
-        float ny = y + std::sin(angles[i]) * sensor;
-        float p_food = sample_field(phero_food, nx, ny) * genome.pheromone_gain * profile.food_attraction_mul;
-        float p_danger = sample_field(phero_danger, nx, ny) * genome.pheromone_gain * profile.danger_aversion_mul;
-        float r = sample_field(resources, nx, ny) * profile.resource_weight_mul;
-        float m = sample_field(molecules, nx, ny) * profile.molecule_weight_mul;
-        float my = sample_field(mycel, nx, ny) * profile.mycel_attraction_mul;
+        float p_food = sensed.phero_food[i] * genome.pheromone_gain * profile.food_attraction_mul;
+        float p_danger = sensed.phero_danger[i] * genome.pheromone_gain * profile.danger_aversion_mul;
+        float r = sensed.resources[i] * profile.resource_weight_mul;
+        float m = sensed.molecules[i] * profile.molecule_weight_mul;
+        float my = sensed.mycel[i] * profile.mycel_attraction_mul;
         float signal = p_food + p_danger + my;
         float novelty = 1.0f - std::min(1.0f, std::max(0.0f, signal));
         float w = p_food + r + 0.25f * m + my + profile.novelty_weight * novelty - p_danger;
@@ -66,33 +134,38 @@ void Agent::step(Rng &rng,
         pick -= weights[i];
     }
 
-    heading = wrap_angle(angles[choice] + rng.uniform(-turn, turn) * genome.exploration_bias);
+    const float jitter = rng.uniform(-turn, turn) * genome.exploration_bias;
+    if (params.agent_fast_steering) {
+        const BinaryAngle angle =
+            static_cast<BinaryAngle>(to_binary_angle(sensed.angles[choice]) + to_binary_angle(jitter));
+        const SinCos &dir = sin_cos(angle);
+        const float nx = x + dir.c;
+        const float ny = y + dir.s;
+        if (nx >= 0.0f && ny >= 0.0f && nx < width && ny < height) {
+            heading = from_binary_angle(angle);
+            x = nx;
+            y = ny;
+            return false;
+        }
+        heading = from_binary_angle(static_cast<BinaryAngle>(angle + kHalfTurnAngle));
+        return true;
+    }
+
+    heading = wrap_angle(sensed.angles[choice] + jitter);
 
     float nx = x + std::cos(heading);
     float ny = y + std::sin(heading);
 
-    bool bounced = false;
-    if (nx >= 0.0f && ny >= 0.0f && nx < phero_food.width && ny < phero_food.height) {
+    if (nx >= 0.0f && ny >= 0.0f && nx < width && ny < height) {
         x = nx;
         y = ny;
-    } else {
-        heading = wrap_angle(heading + 3.1415926f);
-        bounced = true;
-    }
-
-    int cx = static_cast<int>(x);
-    int cy = static_cast<int>(y);
-    if (cx >= 0 && cy >= 0 && cx < resources.width && cy < resources.height) {
-        float &cell = resources.at(cx, cy);
-        float harvested = std::min(cell, params.agent_harvest);
-        cell -= harvested;
-        energy += harvested;
-
-        float deposit = params.phero_food_deposit_scale * harvested;
-        phero_food.at(cx, cy) += deposit * profile.deposit_food_mul;
-        molecules.at(cx, cy) += harvested * 0.5f;
+        return false;
     }
+    heading = wrap_angle(heading + 3.1415926f);
+    return true;
+}
 
+float Agent::settle(const SimParams &params, int fitness_window) {
     energy -= params.agent_move_cost;
     if (energy < 0.0f) {
         energy = 0.0f;
@@ -108,7 +181,10 @@ void Agent::step(Rng &rng,
         fitness_accum = 0.0f;
         fitness_ticks = 0;
     }
+    return delta;
+}
 
+float danger_deposit_amount(const SimParams &params, bool bounced, float delta) {
     float danger_deposit = 0.0f;
     if (bounced) {
         danger_deposit += params.danger_bounce_deposit;
@@ -116,11 +192,59 @@ void Agent::step(Rng &rng,
     if (delta < -params.danger_delta_threshold) {
         danger_deposit += (-delta) * params.phero_danger_deposit_scale;
     }
+    return danger_deposit;
+}
+
+float counter_deposit_food(const SpeciesProfile &profile, float local_food, float local_mycel) {
+    float density = local_food + local_mycel;
+    if (density > profile.over_density_threshold) {
+        float reduction = (density - profile.over_density_threshold) * profile.counter_deposit_mul;
+        return std::max(0.0f, local_food - reduction);
+    }
+    return local_food;
+}
+
+float sample_cell(const GridField &field, int x, int y) {
+    return sample_field(field, static_cast<float>(x), static_cast<float>(y));
+}
+
+void Agent::act(Rng &rng,
+                const SimParams &params,
+                int fitness_window,
+                const SpeciesProfile &profile,
+                const AgentSense &sensed,
+                GridField &phero_food,
+                GridField &phero_danger,
+                GridField &molecules,
+                GridField &resources,
+                const GridField &mycel) {
+    last_energy = energy;
+    const bool bounced = steer(rng, params, profile, sensed, phero_food.width, phero_food.height);
+
+    int cx = static_cast<int>(x);
+    int cy = static_cast<int>(y);
+    if (cx >= 0 && cy >= 0 && cx < resources.width && cy < resources.height) {
+        float &cell = resources.at(cx, cy);
+        float harvested = std::min(cell, params.agent_harvest);
+        cell -= harvested;
+        energy += harvested;
+
+        float deposit = params.phero_food_deposit_scale * harvested;
+        phero_food.add(cx, cy, deposit * profile.deposit_food_mul);
+        molecules.add(cx, cy, harvested * 0.5f);
+        phero_food.mark_active(cx, cy);
+        molecules.mark_active(cx, cy);
+    }
+
+    const float delta = settle(params, fitness_window);
+
+    float danger_deposit = danger_deposit_amount(params, bounced, delta);
     if (danger_deposit > 0.0f) {
         int dx = static_cast<int>(x);
         int dy = static_cast<int>(y);
         if (dx >= 0 && dy >= 0 && dx < phero_danger.width && dy < phero_danger.height) {
-            phero_danger.at(dx, dy) += danger_deposit * profile.deposit_danger_mul;
+            phero_danger.add(dx, dy, danger_deposit * profile.deposit_danger_mul);
+            phero_danger.mark_active(dx, dy);
         }
     }
 
@@ -128,12 +252,10 @@ void Agent::step(Rng &rng,
         int dx = static_cast<int>(x);
         int dy = static_cast<int>(y);
         if (dx >= 0 && dy >= 0 && dx < phero_food.width && dy < phero_food.height) {
-            float local_food = phero_food.at(dx, dy);
-            float local_mycel = sample_field(mycel, static_cast<float>(dx), static_cast<float>(dy));
-            float density = local_food + local_mycel;
-            if (density > profile.over_density_threshold) {
-                float reduction = (density - profile.over_density_threshold) * profile.counter_deposit_mul;
-                phero_food.at(dx, dy) = std::max(0.0f, local_food - reduction);
+            float local_food = phero_food.get(dx, dy);
+            float reduced = counter_deposit_food(profile, local_food, sample_cell(mycel, dx, dy));
+            if (reduced != local_food) {
+                phero_food.set(dx, dy, reduced);
             }
         }
     }
@@ -3,6 +3,7 @@
 #include "dna_memory.h"
 #include "fields.h"
 #include "params.h"
+#include "pyramid.h"
 #include "rng.h"
 
 struct SpeciesProfile {
@@ -22,6 +23,39 @@ struct SpeciesProfile {
     float counter_deposit_mul = 0.0f;
 };
 
+// Pyramiden der Sensorfelder fuer agent_sense_lod_radius; vor der Agentenphase aktualisiert.
+struct SenseLod {
+    const FieldPyramid *phero_food = nullptr;
+    const FieldPyramid *phero_danger = nullptr;
+    const FieldPyramid *molecules = nullptr;
+    const FieldPyramid *resources = nullptr;
+    const FieldPyramid *mycel = nullptr;
+};
+
+// Sensorwerte eines Schritts: drei Richtungen (heading - 0.6, heading, heading + 0.6).
+struct AgentSense {
+    float angles[3] = {};
+    float phero_food[3] = {};
+    float phero_danger[3] = {};
+    float molecules[3] = {};
+    float resources[3] = {};
+    float mycel[3] = {};
+};
+
+// Sensorrichtungen und -punkte eines Agenten; mit agent_fast_steering ueber Binaerwinkel und
+// Tabelle statt cos/sin (Richtungen dann auf Binaerwinkel gerundet).
+void sensor_probes(const SimParams &params, float x, float y, float heading, float sensor, float angles[3],
+                   float px[3], float py[3]);
+// Pyramidenstufe fuer einen Sensorradius (0 = volle Aufloesung) und Abtastung auf dieser Stufe.
+int sense_level(const SimParams &params, float sensor, const SenseLod *lod);
+float sample_sense_field(const GridField &field, const FieldPyramid *pyramid, int level, float fx, float fy);
+// Zelle (x, y) wie beim Abtasten; ausserhalb liefert die Geisterzelle 0.
+float sample_cell(const GridField &field, int x, int y);
+// Gefahren-Deposit nach einem Schritt (Abprall, Energieeinbruch um mehr als danger_delta_threshold).
+float danger_deposit_amount(const SimParams &params, bool bounced, float delta);
+// Futterpheromon der Zelle nach dem Gegen-Deposit bei Ueberdichte (nur mit counter_deposit_mul > 0).
+float counter_deposit_food(const SpeciesProfile &profile, float local_food, float local_mycel);
+
 struct Agent {
     float x = 0.0f;
     float y = 0.0f;
@@ -42,5 +76,32 @@ struct Agent {
               GridField &phero_danger,
               GridField &molecules,
               GridField &resources,
-              const GridField &mycel);
+              const GridField &mycel,
+              const SenseLod *lod = nullptr);
+
+    // step() in zwei Teilen: sense() liest nur, act() waehlt die Richtung, bewegt, erntet und deponiert.
+    void sense(const SimParams &params,
+               const GridField &phero_food,
+               const GridField &phero_danger,
+               const GridField &molecules,
+               const GridField &resources,
+               const GridField &mycel,
+               const SenseLod *lod,
+               AgentSense &out) const;
+    void act(Rng &rng,
+             const SimParams &params,
+             int fitness_window,
+             const SpeciesProfile &profile,
+             const AgentSense &sensed,
+             GridField &phero_food,
+             GridField &phero_danger,
+             GridField &molecules,
+             GridField &resources,
+             const GridField &mycel);
+
+    // Teile von act(): steer() waehlt die Richtung und bewegt (true = abgeprallt),
+    // settle() zieht die Bewegungskosten ab und fuehrt die Fitness nach (Rueckgabe: Energiedelta).
+    bool steer(Rng &rng, const SimParams &params, const SpeciesProfile &profile, const AgentSense &sensed,
+               int width, int height);
+    float settle(const SimParams &params, int fitness_window);
 };
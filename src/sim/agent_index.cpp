@@ -0,0 +1,106 @@
+#include "agent_index.h"
+
+#include <algorithm>
+
+namespace {
+// Monoton und NaN-fest (NaN landet auf Zelle 0).
+int bucket(float v, int limit) {
+    return static_cast<int>(std::max(0.0f, std::min(v, static_cast<float>(limit - 1))));
+}
+} // namespace
+
+void AgentIndex::rebuild(const AgentSoA &agents, int grid_width, int grid_height) {
+    width = grid_width;
+    height = grid_height;
+    const std::size_t cells = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    cell_start.assign(cells + 1, 0);
+    ids.resize(agents.size());
+    if (cells == 0) {
+        ids.clear();
+        return;
+    }
+
+    for (std::size_t i = 0; i < agents.size(); ++i) {
+        const int c = bucket(agents.y[i], height) * width + bucket(agents.x[i], width);
+        cell_start[c + 1] += 1;
+    }
+    for (std::size_t c = 0; c < cells; ++c) {
+        cell_start[c + 1] += cell_start[c];
+    }
+    cursor.assign(cell_start.begin(), cell_start.end() - 1);
+    for (std::size_t i = 0; i < agents.size(); ++i) {
+        const int c = bucket(agents.y[i], height) * width + bucket(agents.x[i], width);
+        ids[cursor[c]++] = static_cast<int>(i);
+    }
+}
+
+int AgentIndex::query_rect(const AgentSoA &agents, float x0, float y0, float x1, float y1, int *out,
+                           int max_out) const {
+    if (width <= 0 || height <= 0 || !(x0 < x1) || !(y0 < y1)) {
+        return 0;
+    }
+    const int cx0 = bucket(x0, width);
+    const int cx1 = bucket(x1, width);
+    const int cy0 = bucket(y0, height);
+    const int cy1 = bucket(y1, height);
+    int found = 0;
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        const int begin = cell_start[cy * width + cx0];
+        const int end = cell_start[cy * width + cx1 + 1];
+        for (int k = begin; k < end; ++k) {
+            const int i = ids[k];
+            const float x = agents.x[i];
+            const float y = agents.y[i];
+            if (x >= x0 && x < x1 && y >= y0 && y < y1) {
+                if (found < max_out) {
+                    out[found] = i;
+                }
+                ++found;
+            }
+        }
+    }
+    return found;
+}
+
+int AgentIndex::query_radius(const AgentSoA &agents, float cx, float cy, float radius, int *out,
+                             int max_out) const {
+    if (width <= 0 || height <= 0 || !(radius >= 0.0f)) {
+        return 0;
+    }
+    const int cx0 = bucket(cx - radius, width);
+    const int cx1 = bucket(cx + radius, width);
+    const int cy0 = bucket(cy - radius, height);
+    const int cy1 = bucket(cy + radius, height);
+    const float r2 = radius * radius;
+    int found = 0;
+    for (int gy = cy0; gy <= cy1; ++gy) {
+        const int begin = cell_start[gy * width + cx0];
+        const int end = cell_start[gy * width + cx1 + 1];
+        for (int k = begin; k < end; ++k) {
+            const int i = ids[k];
+            const float dx = agents.x[i] - cx;
+            const float dy = agents.y[i] - cy;
+            if (dx * dx + dy * dy <= r2) {
+                if (found < max_out) {
+                    out[found] = i;
+                }
+                ++found;
+            }
+        }
+    }
+    return found;
+}
+
+void AgentIndex::density(GridField &out) const {
+    if (out.width != width || out.height != height) {
+        out = GridField(width, height, 0.0f);
+    }
+    for (int y = 0; y < height; ++y) {
+        float *row = out.row(y);
+        const int *start = cell_start.data() + static_cast<std::size_t>(y) * width;
+        for (int x = 0; x < width; ++x) {
+            row[x] = static_cast<float>(start[x + 1] - start[x]);
+        }
+    }
+    out.mark_all_active();
+}
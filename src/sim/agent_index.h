@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+
+#include "agent_soa.h"
+#include "fields.h"
+
+// Zellliste der Agenten: Agenten per Counting Sort nach Rasterzelle (int(x), int(y)) sortiert,
+// Aufbau in O(n + Zellen). Agenten der Zelle c sind ids[cell_start[c] .. cell_start[c + 1]),
+// aufsteigend nach Index. Positionen ausserhalb des Rasters zaehlen zur naechsten Randzelle.
+struct AgentIndex {
+    int width = 0;
+    int height = 0;
+    std::vector<int> cell_start;
+    std::vector<int> ids;
+
+    void rebuild(const AgentSoA &agents, int grid_width, int grid_height);
+    int cell_count(int x, int y) const {
+        const int c = y * width + x;
+        return cell_start[c + 1] - cell_start[c];
+    }
+
+    // Agenten mit x0 <= x < x1 und y0 <= y < y1 bzw. Abstand <= radius. Schreibt hoechstens max_out
+    // Indizes (Zellreihenfolge) und liefert die Gesamtzahl der Treffer.
+    int query_rect(const AgentSoA &agents, float x0, float y0, float x1, float y1, int *out, int max_out) const;
+    int query_radius(const AgentSoA &agents, float cx, float cy, float radius, int *out, int max_out) const;
+
+    // Agenten pro Zelle als Feld (gleiche Groesse wie das Raster).
+    void density(GridField &out) const;
+
+private:
+    std::vector<int> cursor;
+};
@@ -0,0 +1,466 @@
+#include "agent_soa.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+#include "thread_pool.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+constexpr int kBatch = AgentSoA::kBatch;
+constexpr int kPoints = 3 * kBatch;
+
+int clamp_cell(float f, int limit) {
+    return std::min(std::max(static_cast<int>(f), -1), limit);
+}
+
+// kPoints Zellen (Geisterzellen erlaubt) eines Felds auf einmal lesen.
+void gather_cells(const GridField &field, const int *cx, const int *cy, float *out) {
+#if defined(__AVX2__)
+    const bool offsets_fit = static_cast<int64_t>(field.height + 1) * field.stride + field.width < INT_MAX;
+    if (field.precision() == FieldPrecision::Float32 && offsets_fit) {
+        const float *base = field.row(0);
+        const __m256i stride = _mm256_set1_epi32(field.stride);
+        for (int i = 0; i < kPoints; i += 8) {
+            __m256i xs = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cx + i));
+            __m256i ys = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cy + i));
+            __m256i offsets = _mm256_add_epi32(_mm256_mullo_epi32(ys, stride), xs);
+            _mm256_storeu_ps(out + i, _mm256_i32gather_ps(base, offsets, 4));
+        }
+        return;
+    }
+#endif
+    for (int i = 0; i < kPoints; ++i) {
+        out[i] = field.get(cx[i], cy[i]);
+    }
+}
+} // namespace
+
+void AgentSoA::clear() {
+    for (FloatArray *array : {&x, &y, &heading, &energy, &last_energy, &fitness_accum, &fitness_value,
+                              &sense_gain, &pheromone_gain, &exploration_bias}) {
+        array->clear();
+    }
+    fitness_ticks.clear();
+    species.clear();
+    id.clear();
+    slot_of_id.clear();
+}
+
+void AgentSoA::reserve(std::size_t count) {
+    for (FloatArray *array : {&x, &y, &heading, &energy, &last_energy, &fitness_accum, &fitness_value,
+                              &sense_gain, &pheromone_gain, &exploration_bias}) {
+        array->reserve(count);
+    }
+    fitness_ticks.reserve(count);
+    species.reserve(count);
+    id.reserve(count);
+    slot_of_id.reserve(count);
+}
+
+void AgentSoA::push_back(const Agent &agent) {
+    x.push_back(agent.x);
+    y.push_back(agent.y);
+    heading.push_back(agent.heading);
+    energy.push_back(agent.energy);
+    last_energy.push_back(agent.last_energy);
+    fitness_accum.push_back(agent.fitness_accum);
+    fitness_ticks.push_back(agent.fitness_ticks);
+    fitness_value.push_back(agent.fitness_value);
+    species.push_back(agent.species);
+    sense_gain.push_back(agent.genome.sense_gain);
+    pheromone_gain.push_back(agent.genome.pheromone_gain);
+    exploration_bias.push_back(agent.genome.exploration_bias);
+    id.push_back(static_cast<int>(slot_of_id.size()));
+    slot_of_id.push_back(static_cast<int>(x.size()) - 1);
+}
+
+Agent AgentSoA::get(std::size_t i) const {
+    Agent agent;
+    agent.x = x[i];
+    agent.y = y[i];
+    agent.heading = heading[i];
+    agent.energy = energy[i];
+    agent.last_energy = last_energy[i];
+    agent.fitness_accum = fitness_accum[i];
+    agent.fitness_ticks = fitness_ticks[i];
+    agent.fitness_value = fitness_value[i];
+    agent.species = species[i];
+    agent.genome = genome(i);
+    return agent;
+}
+
+void AgentSoA::set(std::size_t i, const Agent &agent) {
+    x[i] = agent.x;
+    y[i] = agent.y;
+    heading[i] = agent.heading;
+    energy[i] = agent.energy;
+    last_energy[i] = agent.last_energy;
+    fitness_accum[i] = agent.fitness_accum;
+    fitness_ticks[i] = agent.fitness_ticks;
+    fitness_value[i] = agent.fitness_value;
+    species[i] = agent.species;
+    sense_gain[i] = agent.genome.sense_gain;
+    pheromone_gain[i] = agent.genome.pheromone_gain;
+    exploration_bias[i] = agent.genome.exploration_bias;
+}
+
+namespace {
+// Bits 0..15 von v auf die geraden Bitpositionen verteilen.
+uint32_t spread_bits(uint32_t v) {
+    v &= 0xffffu;
+    v = (v | (v << 8)) & 0x00ff00ffu;
+    v = (v | (v << 4)) & 0x0f0f0f0fu;
+    v = (v | (v << 2)) & 0x33333333u;
+    v = (v | (v << 1)) & 0x55555555u;
+    return v;
+}
+
+uint32_t morton_cell(float x, float y) {
+    const uint32_t cx = static_cast<uint32_t>(std::max(0.0f, std::min(x, 65535.0f)));
+    const uint32_t cy = static_cast<uint32_t>(std::max(0.0f, std::min(y, 65535.0f)));
+    return spread_bits(cx) | (spread_bits(cy) << 1);
+}
+
+template <typename Array>
+void permute(Array &array, const std::vector<uint64_t> &keys, Array &tmp) {
+    tmp.resize(array.size());
+    for (std::size_t k = 0; k < keys.size(); ++k) {
+        tmp[k] = array[static_cast<uint32_t>(keys[k])];
+    }
+    array.swap(tmp);
+}
+} // namespace
+
+void sort_agents_morton(AgentSoA &agents, AgentSortScratch &scratch) {
+    const std::size_t count = agents.size();
+    scratch.keys.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        scratch.keys[i] = (static_cast<uint64_t>(morton_cell(agents.x[i], agents.y[i])) << 32) | i;
+    }
+    std::sort(scratch.keys.begin(), scratch.keys.end());
+    for (AgentSoA::FloatArray *array :
+         {&agents.x, &agents.y, &agents.heading, &agents.energy, &agents.last_energy, &agents.fitness_accum,
+          &agents.fitness_value, &agents.sense_gain, &agents.pheromone_gain, &agents.exploration_bias}) {
+        permute(*array, scratch.keys, scratch.floats);
+    }
+    for (AgentSoA::IntArray *array : {&agents.fitness_ticks, &agents.species, &agents.id}) {
+        permute(*array, scratch.keys, scratch.ints);
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        agents.slot_of_id[agents.id[i]] = static_cast<int>(i);
+    }
+}
+
+namespace {
+// Sensorpunkte und Abtastwerte eines Blocks; Index d * kBatch + l (Richtung d, Agent l).
+// Freie Plaetze und Agenten auf groben Stufen stehen fuer den Gather auf der Geisterzelle.
+struct BatchSense {
+    int count = 0;
+    int level[kBatch] = {};
+    alignas(32) float angle[kPoints];
+    alignas(32) float px[kPoints];
+    alignas(32) float py[kPoints];
+    alignas(32) int cx[kPoints];
+    alignas(32) int cy[kPoints];
+    alignas(32) float food[kPoints];
+    alignas(32) float danger[kPoints];
+    alignas(32) float mol[kPoints];
+    alignas(32) float res[kPoints];
+    alignas(32) float myc[kPoints];
+};
+
+struct SenseFields {
+    const GridField &phero_food;
+    const GridField &phero_danger;
+    const GridField &molecules;
+    const GridField &resources;
+    const GridField &mycel;
+    const SenseLod *lod;
+};
+
+bool same_shape(const SenseFields &fields) {
+    const GridField *others[] = {&fields.phero_danger, &fields.molecules, &fields.resources, &fields.mycel};
+    for (const GridField *field : others) {
+        if (field->width != fields.phero_food.width || field->height != fields.phero_food.height) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void sense_batch(const AgentSoA &agents, std::size_t begin, int count, const SimParams &params,
+                 const SenseFields &fields, BatchSense &out) {
+    const int width = fields.phero_food.width;
+    const int height = fields.phero_food.height;
+    out.count = count;
+    std::fill(out.cx, out.cx + kPoints, -1);
+    std::fill(out.cy, out.cy + kPoints, -1);
+    for (int l = 0; l < count; ++l) {
+        const std::size_t i = begin + l;
+        const float sensor = params.agent_sense_radius * agents.sense_gain[i];
+        out.level[l] = sense_level(params, sensor, fields.lod);
+        float angles[3];
+        float px[3];
+        float py[3];
+        sensor_probes(params, agents.x[i], agents.y[i], agents.heading[i], sensor, angles, px, py);
+        for (int d = 0; d < 3; ++d) {
+            const int p = d * kBatch + l;
+            out.angle[p] = angles[d];
+            out.px[p] = px[d];
+            out.py[p] = py[d];
+            if (out.level[l] == 0) {
+                out.cx[p] = clamp_cell(out.px[p], width);
+                out.cy[p] = clamp_cell(out.py[p], height);
+            }
+        }
+    }
+    gather_cells(fields.phero_food, out.cx, out.cy, out.food);
+    gather_cells(fields.phero_danger, out.cx, out.cy, out.danger);
+    gather_cells(fields.molecules, out.cx, out.cy, out.mol);
+    gather_cells(fields.resources, out.cx, out.cy, out.res);
+    gather_cells(fields.mycel, out.cx, out.cy, out.myc);
+}
+
+void lane_sense(const BatchSense &batch, int l, const SenseFields &fields, AgentSense &out) {
+    const SenseLod pyramids = fields.lod ? *fields.lod : SenseLod{};
+    const int level = batch.level[l];
+    for (int d = 0; d < 3; ++d) {
+        const int p = d * kBatch + l;
+        out.angles[d] = batch.angle[p];
+        if (level != 0) {
+            out.phero_food[d] = sample_sense_field(fields.phero_food, pyramids.phero_food, level, batch.px[p], batch.py[p]);
+            out.phero_danger[d] =
+                sample_sense_field(fields.phero_danger, pyramids.phero_danger, level, batch.px[p], batch.py[p]);
+            out.resources[d] = sample_sense_field(fields.resources, pyramids.resources, level, batch.px[p], batch.py[p]);
+            out.molecules[d] = sample_sense_field(fields.molecules, pyramids.molecules, level, batch.px[p], batch.py[p]);
+            out.mycel[d] = sample_sense_field(fields.mycel, pyramids.mycel, level, batch.px[p], batch.py[p]);
+            continue;
+        }
+        out.phero_food[d] = batch.food[p];
+        out.phero_danger[d] = batch.danger[p];
+        out.molecules[d] = batch.mol[p];
+        out.resources[d] = batch.res[p];
+        out.mycel[d] = batch.myc[p];
+    }
+}
+} // namespace
+
+void step_agent_batch(AgentSoA &agents,
+                      std::size_t begin,
+                      std::size_t end,
+                      uint32_t seed,
+                      uint32_t step,
+                      const SimParams &params,
+                      int fitness_window,
+                      const SpeciesProfile *profiles,
+                      GridField &phero_food,
+                      GridField &phero_danger,
+                      GridField &molecules,
+                      Environment &env,
+                      const GridField &mycel,
+                      const SenseLod *lod) {
+    const int count = static_cast<int>(std::min<std::size_t>(end - begin, kBatch));
+    GridField &resources = env.resources;
+    for (int l = 0; l < count; ++l) {
+        const std::size_t i = begin + l;
+        env.materialize_around(agents.x[i], agents.y[i], params.agent_sense_radius * agents.sense_gain[i] + 2.0f);
+    }
+
+    const SenseFields fields{phero_food, phero_danger, molecules, resources, mycel, lod};
+    if (!same_shape(fields)) {
+        for (int l = 0; l < count; ++l) {
+            Agent agent = agents.get(begin + l);
+            Rng rng = Rng::stream(seed, RngDomain::AgentStep, static_cast<uint32_t>(agents.id[begin + l]), step);
+            agent.step(rng, params, fitness_window, profiles[agent.species], phero_food, phero_danger, molecules,
+                       resources, mycel, lod);
+            agents.set(begin + l, agent);
+        }
+        return;
+    }
+
+    BatchSense batch;
+    sense_batch(agents, begin, count, params, fields, batch);
+
+    int written_x[kBatch];
+    int written_y[kBatch];
+    int written = 0;
+    for (int l = 0; l < count; ++l) {
+        const std::size_t i = begin + l;
+        if (batch.level[l] == 0) {
+            for (int d = 0; d < 3; ++d) {
+                const int p = d * kBatch + l;
+                bool stale = false;
+                for (int k = 0; k < written; ++k) {
+                    stale |= written_x[k] == batch.cx[p] && written_y[k] == batch.cy[p];
+                }
+                if (stale) {
+                    batch.food[p] = phero_food.get(batch.cx[p], batch.cy[p]);
+                    batch.danger[p] = phero_danger.get(batch.cx[p], batch.cy[p]);
+                    batch.mol[p] = molecules.get(batch.cx[p], batch.cy[p]);
+                    batch.res[p] = resources.get(batch.cx[p], batch.cy[p]);
+                }
+            }
+        }
+        AgentSense sensed;
+        lane_sense(batch, l, fields, sensed);
+
+        Agent agent = agents.get(i);
+        Rng rng = Rng::stream(seed, RngDomain::AgentStep, static_cast<uint32_t>(agents.id[i]), step);
+        agent.act(rng, params, fitness_window, profiles[agent.species], sensed, phero_food, phero_danger, molecules,
+                  resources, mycel);
+        agents.set(i, agent);
+
+        // act() schreibt nur in die Zelle, auf der der Agent danach steht.
+        const int wx = static_cast<int>(agent.x);
+        const int wy = static_cast<int>(agent.y);
+        if (wx >= 0 && wy >= 0 && wx < phero_food.width && wy < phero_food.height) {
+            written_x[written] = wx;
+            written_y[written] = wy;
+            ++written;
+        }
+    }
+}
+
+void step_agents_parallel(AgentSoA &agents,
+                          uint32_t seed,
+                          uint32_t step,
+                          const SimParams &params,
+                          int fitness_window,
+                          const SpeciesProfile *profiles,
+                          GridField &phero_food,
+                          GridField &phero_danger,
+                          GridField &molecules,
+                          Environment &env,
+                          const GridField &mycel,
+                          const SenseLod *lod,
+                          ThreadPool *pool,
+                          AgentParallelScratch &scratch) {
+    const std::size_t count = agents.size();
+    const int chunks = static_cast<int>((count + kParallelChunk - 1) / kParallelChunk);
+    GridField &resources = env.resources;
+    scratch.bounced.resize(count);
+    scratch.harvested.resize(count);
+    while (scratch.deposits.size() < static_cast<std::size_t>(chunks)) {
+        scratch.deposits.emplace_back();
+        scratch.deposits.back().reserve(kParallelChunk);
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        env.materialize_around(agents.x[i], agents.y[i], params.agent_sense_radius * agents.sense_gain[i] + 2.0f);
+    }
+
+    const SenseFields fields{phero_food, phero_danger, molecules, resources, mycel, lod};
+    const bool shape_ok = same_shape(fields);
+    auto chunk_range = [&](int chunk, std::size_t &begin, std::size_t &end) {
+        begin = static_cast<std::size_t>(chunk) * kParallelChunk;
+        end = std::min(count, begin + kParallelChunk);
+    };
+
+    // 1. Abtasten und Bewegen gegen denselben Feldstand.
+    parallel_for(pool, 0, chunks, [&](int c0, int c1) {
+        for (int chunk = c0; chunk < c1; ++chunk) {
+            std::size_t begin = 0;
+            std::size_t end = 0;
+            chunk_range(chunk, begin, end);
+            BatchSense batch;
+            for (std::size_t base = begin; base < end; base += kBatch) {
+                const int lanes = static_cast<int>(std::min<std::size_t>(end - base, kBatch));
+                if (shape_ok) {
+                    sense_batch(agents, base, lanes, params, fields, batch);
+                }
+                for (int l = 0; l < lanes; ++l) {
+                    const std::size_t i = base + l;
+                    Agent agent = agents.get(i);
+                    AgentSense sensed;
+                    if (shape_ok) {
+                        lane_sense(batch, l, fields, sensed);
+                    } else {
+                        agent.sense(params, phero_food, phero_danger, molecules, resources, mycel, lod, sensed);
+                    }
+                    agent.last_energy = agent.energy;
+                    Rng rng = Rng::stream(seed, RngDomain::AgentStep, static_cast<uint32_t>(agents.id[i]), step);
+                    scratch.bounced[i] = agent.steer(rng, params, profiles[agent.species], sensed, phero_food.width,
+                                                     phero_food.height) ? 1 : 0;
+                    agents.set(i, agent);
+                }
+            }
+        }
+    });
+
+    // 2. Ernte in Agentenreihenfolge.
+    for (std::size_t i = 0; i < count; ++i) {
+        const int cx = static_cast<int>(agents.x[i]);
+        const int cy = static_cast<int>(agents.y[i]);
+        float harvested = -1.0f;
+        if (cx >= 0 && cy >= 0 && cx < resources.width && cy < resources.height) {
+            float &cell = resources.at(cx, cy);
+            harvested = std::min(cell, params.agent_harvest);
+            cell -= harvested;
+        }
+        scratch.harvested[i] = harvested;
+    }
+
+    // 3. Energie, Fitness und Deposits in die Blockpuffer.
+    parallel_for(pool, 0, chunks, [&](int c0, int c1) {
+        for (int chunk = c0; chunk < c1; ++chunk) {
+            std::vector<AgentDeposit> &deposits = scratch.deposits[static_cast<std::size_t>(chunk)];
+            deposits.clear();
+            std::size_t begin = 0;
+            std::size_t end = 0;
+            chunk_range(chunk, begin, end);
+            for (std::size_t i = begin; i < end; ++i) {
+                Agent agent = agents.get(i);
+                const SpeciesProfile &profile = profiles[agent.species];
+                const float harvested = scratch.harvested[i];
+                AgentDeposit deposit;
+                deposit.x = static_cast<int>(agent.x);
+                deposit.y = static_cast<int>(agent.y);
+                const bool on_grid = harvested >= 0.0f;
+                if (on_grid) {
+                    agent.energy += harvested;
+                    deposit.food = params.phero_food_deposit_scale * harvested * profile.deposit_food_mul;
+                    deposit.molecules = harvested * 0.5f;
+                }
+                const float delta = agent.settle(params, fitness_window);
+                const float danger = danger_deposit_amount(params, scratch.bounced[i] != 0, delta);
+                if (danger > 0.0f && on_grid) {
+                    deposit.danger = danger * profile.deposit_danger_mul;
+                }
+                if (profile.counter_deposit_mul > 0.0f && on_grid) {
+                    const float local_food = phero_food.get(deposit.x, deposit.y) + deposit.food;
+                    const float reduced =
+                        counter_deposit_food(profile, local_food, sample_cell(mycel, deposit.x, deposit.y));
+                    if (reduced != local_food) {
+                        deposit.food += reduced - local_food;
+                        deposit.clamp_food = true;
+                    }
+                }
+                agents.set(i, agent);
+                if (on_grid) {
+                    deposits.push_back(deposit);
+                }
+            }
+        }
+    });
+
+    // 4. Zusammenfuehren in Blockreihenfolge.
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        for (const AgentDeposit &deposit : scratch.deposits[static_cast<std::size_t>(chunk)]) {
+            phero_food.add(deposit.x, deposit.y, deposit.food);
+            molecules.add(deposit.x, deposit.y, deposit.molecules);
+            phero_food.mark_active(deposit.x, deposit.y);
+            molecules.mark_active(deposit.x, deposit.y);
+            if (deposit.danger > 0.0f) {
+                phero_danger.add(deposit.x, deposit.y, deposit.danger);
+                phero_danger.mark_active(deposit.x, deposit.y);
+            }
+            if (deposit.clamp_food && phero_food.get(deposit.x, deposit.y) < 0.0f) {
+                phero_food.set(deposit.x, deposit.y, 0.0f);
+            }
+        }
+    }
+}
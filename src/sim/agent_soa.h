@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "agent.h"
+#include "environment.h"
+#include "fields.h"
+
+// Agenten als Structure of Arrays: je Attribut ein eigenes, 64-Byte-ausgerichtetes Array.
+// Index i ist der Platz eines Agenten; get()/set() tauschen einen ganzen Agenten als Agent-Wert aus.
+// Jeder Agent hat zusaetzlich eine stabile ID (0..n-1 in Einfuegereihenfolge), die beim Umsortieren
+// erhalten bleibt; id[i] ist die ID auf Platz i, slot_of_id[id] der Platz einer ID.
+struct AgentSoA {
+    static constexpr int kBatch = 8;
+    using FloatArray = std::vector<float, AlignedAllocator<float>>;
+    using IntArray = std::vector<int, AlignedAllocator<int>>;
+
+    FloatArray x;
+    FloatArray y;
+    FloatArray heading;
+    FloatArray energy;
+    FloatArray last_energy;
+    FloatArray fitness_accum;
+    IntArray fitness_ticks;
+    FloatArray fitness_value;
+    IntArray species;
+    FloatArray sense_gain;
+    FloatArray pheromone_gain;
+    FloatArray exploration_bias;
+    IntArray id;
+    std::vector<int> slot_of_id;
+
+    std::size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+    void clear();
+    void reserve(std::size_t count);
+    void push_back(const Agent &agent);
+    Agent get(std::size_t i) const;
+    void set(std::size_t i, const Agent &agent);
+    Genome genome(std::size_t i) const { return Genome{sense_gain[i], pheromone_gain[i], exploration_bias[i]}; }
+};
+
+// Agenten [begin, end) (hoechstens kBatch) mit demselben Ergebnis wie Agent::step der Reihe nach.
+// Sensorpunkte und Abtastungen laufen ueber den ganzen Block (Gather); trifft ein Punkt die Zelle,
+// in die ein frueherer Agent des Blocks geschrieben hat, wird er vor act() neu gelesen.
+// Holt im Lazy-Modus die Ressourcen um die Agenten des Blocks selbst nach. Der Agent auf Platz i
+// zieht aus Rng::stream(seed, AgentStep, id[i], step).
+void step_agent_batch(AgentSoA &agents,
+                      std::size_t begin,
+                      std::size_t end,
+                      uint32_t seed,
+                      uint32_t step,
+                      const SimParams &params,
+                      int fitness_window,
+                      const SpeciesProfile *profiles,
+                      GridField &phero_food,
+                      GridField &phero_danger,
+                      GridField &molecules,
+                      Environment &env,
+                      const GridField &mycel,
+                      const SenseLod *lod = nullptr);
+
+// Puffer fuer sort_agents_morton; im Kontext halten, damit im Dauerbetrieb nichts alloziert wird.
+struct AgentSortScratch {
+    std::vector<uint64_t> keys;
+    AgentSoA::FloatArray floats;
+    AgentSoA::IntArray ints;
+};
+
+// Ordnet die Agenten entlang einer Z-Kurve (Morton-Code der Zelle int(x), int(y)); Agenten derselben
+// Zelle behalten ihre bisherige Reihenfolge. Nachbarn im Array tasten dann nahe Speicherbereiche ab.
+// IDs wandern mit, slot_of_id wird nachgefuehrt.
+void sort_agents_morton(AgentSoA &agents, AgentSortScratch &scratch);
+
+// Gepufferte Wirkung eines Agenten auf die Zelle unter ihm (paralleler Agentenschritt).
+struct AgentDeposit {
+    int x = 0;
+    int y = 0;
+    float food = 0.0f;
+    float molecules = 0.0f;
+    float danger = 0.0f;
+    bool clamp_food = false;
+};
+
+// Puffer fuer step_agents_parallel; im Kontext halten, damit im Dauerbetrieb nichts alloziert wird.
+struct AgentParallelScratch {
+    std::vector<uint8_t> bounced;
+    std::vector<float> harvested;
+    std::vector<std::vector<AgentDeposit>> deposits;
+};
+
+// Paralleler Agentenschritt (SimParams::agent_parallel). Die Agenten laufen in festen Bloecken von
+// kParallelChunk mit je eigenem Deposit-Puffer; Zufallszahlen kommen wie im sequentiellen Schritt
+// aus dem Strom des Agenten. Das Ergebnis haengt daher nur vom Seed ab, nicht von der Threadzahl.
+// Ablauf: alle Agenten tasten denselben Feldstand ab und bewegen sich (parallel); danach wird
+// geerntet, und zwar in Agentenreihenfolge: stehen mehrere Agenten auf einer Zelle, nimmt jeder
+// min(Rest, agent_harvest), der mit kleinerem Index zuerst. Energie, Fitness und Deposits folgen
+// parallel in die Blockpuffer, die zum Schluss in Blockreihenfolge addiert werden. Gegen-Deposits
+// beziehen sich auf den Feldstand vor dem Schritt plus den eigenen Deposit; die Zelle wird nach
+// dem Zusammenfuehren auf >= 0 begrenzt.
+constexpr int kParallelChunk = 4096;
+void step_agents_parallel(AgentSoA &agents,
+                          uint32_t seed,
+                          uint32_t step,
+                          const SimParams &params,
+                          int fitness_window,
+                          const SpeciesProfile *profiles,
+                          GridField &phero_food,
+                          GridField &phero_danger,
+                          GridField &molecules,
+                          Environment &env,
+                          const GridField &mycel,
+                          const SenseLod *lod,
+                          ThreadPool *pool,
+                          AgentParallelScratch &scratch);
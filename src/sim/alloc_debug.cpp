@@ -0,0 +1,105 @@
+#include "alloc_debug.h"
+
+#if MICRO_SWARM_DEBUG_ALLOC
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace {
+std::atomic<uint64_t> g_heap_allocations{0};
+
+void *counted_alloc(std::size_t size) {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = std::malloc(size > 0 ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *counted_aligned_alloc(std::size_t size, std::align_val_t align) {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    std::size_t alignment = std::max(static_cast<std::size_t>(align), sizeof(void *));
+    void *ptr = nullptr;
+#ifdef _WIN32
+    ptr = _aligned_malloc(size > 0 ? size : 1, alignment);
+#else
+    if (posix_memalign(&ptr, alignment, size > 0 ? size : 1) != 0) {
+        ptr = nullptr;
+    }
+#endif
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void aligned_free(void *ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+} // namespace
+
+void *operator new(std::size_t size) {
+    return counted_alloc(size);
+}
+
+void *operator new[](std::size_t size) {
+    return counted_alloc(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void *operator new(std::size_t size, std::align_val_t align) {
+    return counted_aligned_alloc(size, align);
+}
+
+void *operator new[](std::size_t size, std::align_val_t align) {
+    return counted_aligned_alloc(size, align);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    aligned_free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    aligned_free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+    aligned_free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+    aligned_free(ptr);
+}
+
+uint64_t debug_heap_allocations() {
+    return g_heap_allocations.load(std::memory_order_relaxed);
+}
+#else
+uint64_t debug_heap_allocations() {
+    return 0;
+}
+#endif
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+#ifndef MICRO_SWARM_DEBUG_ALLOC
+#define MICRO_SWARM_DEBUG_ALLOC 0
+#endif
+
+// Anzahl Heap-Allokationen seit Programmstart. Nur mit MICRO_SWARM_DEBUG_ALLOC=1 gezaehlt, sonst immer 0.
+uint64_t debug_heap_allocations();
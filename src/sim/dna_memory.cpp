@@ -1,26 +1,139 @@
 #include "dna_memory.h"
 
 #include <algorithm>
+#include <cmath>
 
-void DNAMemory::add(const SimParams &params, const Genome &genome, float fitness, const EvoParams &evo, int capacity_override) {
-    entries.push_back({genome, fitness, 0});
-    std::sort(entries.begin(), entries.end(), [](const DNAEntry &a, const DNAEntry &b) {
-        return a.fitness > b.fitness;
+namespace {
+// Ausserhalb dieses Bereichs wird die Skala in die Eintraege eingerechnet, bevor sie unter- oder ueberlaeuft.
+constexpr float kMinFitnessScale = 1e-20f;
+constexpr float kMaxFitnessScale = 1e20f;
+} // namespace
+
+void DNAMemory::add(const SimParams &params, const Genome &genome, float fitness, int capacity_override) {
+    int capacity = (capacity_override > 0) ? capacity_override : params.dna_capacity;
+    if (capacity <= 0) {
+        entries.clear();
+        return;
+    }
+    const float raw = fitness / fitness_scale;
+    if (std::isnan(raw)) {
+        return;
+    }
+    const size_t cap = static_cast<size_t>(capacity);
+    if (entries.size() >= cap) {
+        if (entries.size() > cap) {
+            entries.resize(cap);
+        }
+        // Voller Pool: nur Genome, die das schlechteste verdraengen, werden einsortiert.
+        if (!(raw > entries.back().raw_fitness)) {
+            return;
+        }
+        entries.pop_back();
+    } else if (entries.capacity() < cap) {
+        entries.reserve(cap);
+    }
+    auto pos = std::upper_bound(entries.begin(), entries.end(), raw, [](float f, const DNAEntry &e) {
+        return f > e.raw_fitness;
     });
+    entries.insert(pos, {genome, raw, epoch});
+    weights_dirty = true;
+}
+
+void DNAMemory::add_batch(const SimParams &params, const std::vector<DNACandidate> &candidates, int species,
+                          int capacity_override) {
     int capacity = (capacity_override > 0) ? capacity_override : params.dna_capacity;
-    if (static_cast<int>(entries.size()) > capacity) {
-        entries.resize(capacity);
+    const size_t cap = static_cast<size_t>(std::max(0, capacity));
+    // Nur was das schlechteste der ersten cap Elemente schlaegt, kann in den Pool.
+    const bool full = entries.size() >= cap;
+    const float threshold = (full && cap > 0) ? entries[cap - 1].raw_fitness : 0.0f;
+    bool any = false;
+    staged.clear();
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (candidates[i].species != species) {
+            continue;
+        }
+        any = true;
+        const float raw = candidates[i].fitness / fitness_scale;
+        if (std::isnan(raw) || (full && !(raw > threshold))) {
+            continue;
+        }
+        staged.push_back({raw, static_cast<int>(i)});
+    }
+    if (!any) {
+        return;
     }
+    if (cap == 0) {
+        entries.clear();
+        return;
+    }
+    if (staged.empty()) {
+        if (entries.size() > cap) {
+            entries.resize(cap);
+        }
+        return;
+    }
+    // Bei gleicher Fitness bleibt die Einfuegereihenfolge: bestehende Eintraege vor Kandidaten,
+    // Kandidaten untereinander nach Listenposition.
+    std::sort(staged.begin(), staged.end(), [](const StagedEntry &a, const StagedEntry &b) {
+        return a.raw_fitness > b.raw_fitness || (a.raw_fitness == b.raw_fitness && a.index < b.index);
+    });
+    merged.clear();
+    if (merged.capacity() < cap) {
+        merged.reserve(cap);
+    }
+    size_t a = 0;
+    size_t b = 0;
+    while (merged.size() < cap && (a < entries.size() || b < staged.size())) {
+        if (b == staged.size() || (a < entries.size() && !(staged[b].raw_fitness > entries[a].raw_fitness))) {
+            merged.push_back(entries[a++]);
+        } else {
+            merged.push_back({candidates[staged[b].index].genome, staged[b].raw_fitness, epoch});
+            ++b;
+        }
+    }
+    entries.swap(merged);
+    weights_dirty = true;
 }
 
 Genome DNAMemory::sample(Rng &rng, const SimParams &params, const EvoParams &evo) const {
-    if (entries.empty()) {
+    DNASampler sampler;
+    sampler.prepare(*this, params, evo);
+    return sampler.sample(rng, evo);
+}
+
+const std::vector<float> &DNAMemory::cumulative_weights(const SimParams &params) const {
+    if (weights_dirty || cumulative.size() != entries.size() || weights_bias != params.dna_survival_bias ||
+        weights_scale != fitness_scale) {
+        cumulative.resize(entries.size());
+        float total = 0.0f;
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            total += std::max(0.0f, fitness(entries[i]) * params.dna_survival_bias + 0.01f);
+            cumulative[i] = total;
+        }
+        weights_bias = params.dna_survival_bias;
+        weights_scale = fitness_scale;
+        weights_dirty = false;
+    }
+    return cumulative;
+}
+
+void DNASampler::prepare(const DNAMemory &pool, const SimParams &params, const EvoParams &evo) {
+    memory = &pool;
+    cumulative = pool.cumulative_weights(params).data();
+    const int count = static_cast<int>(pool.entries.size());
+    elite_count = evo.enabled ? std::max(1, static_cast<int>(count * evo.elite_frac)) : 0;
+    elite_count = std::min(elite_count, count);
+}
+
+Genome DNASampler::sample(Rng &rng, const EvoParams &evo) const {
+    if (!memory || memory->entries.empty()) {
         Genome g;
         g.sense_gain = rng.uniform(0.6f, 1.4f);
         g.pheromone_gain = rng.uniform(0.6f, 1.4f);
         g.exploration_bias = rng.uniform(0.2f, 0.8f);
         return g;
     }
+    const std::vector<DNAEntry> &entries = memory->entries;
 
     auto clamp01 = [](float v) {
         return std::min(1.0f, std::max(0.0f, v));
@@ -30,37 +143,27 @@ Genome DNAMemory::sample(Rng &rng, const SimParams &params, const EvoParams &evo
         return std::min(hi, std::max(lo, v));
     };
 
-    auto weighted_pick = [&](const std::vector<DNAEntry> &pool) -> Genome {
-        float total = 0.0f;
-        for (const auto &entry : pool) {
-            total += entry.fitness * params.dna_survival_bias + 0.01f;
-        }
-        float pick = rng.uniform(0.0f, total);
-        for (const auto &entry : pool) {
-            float w = entry.fitness * params.dna_survival_bias + 0.01f;
-            if (pick <= w) {
-                return entry.genome;
-            }
-            pick -= w;
-        }
-        return pool.front().genome;
+    // Erster Eintrag, dessen kumuliertes Gewicht pick erreicht; die Elite ist ein Praefix.
+    auto weighted_pick = [&](int count) -> Genome {
+        float pick = rng.uniform(0.0f, cumulative[count - 1]);
+        const float *hit = std::lower_bound(cumulative, cumulative + count, pick);
+        return hit == cumulative + count ? entries.front().genome : entries[hit - cumulative].genome;
     };
 
+    const int count = static_cast<int>(entries.size());
     Genome g;
     if (evo.enabled) {
-        int elite_count = std::max(1, static_cast<int>(entries.size() * evo.elite_frac));
         bool from_elite = (rng.uniform(0.0f, 1.0f) < evo.elite_frac);
         if (from_elite && elite_count > 0) {
-            std::vector<DNAEntry> elite(entries.begin(), entries.begin() + elite_count);
-            g = weighted_pick(elite);
+            g = weighted_pick(elite_count);
         } else {
-            g = weighted_pick(entries);
+            g = weighted_pick(count);
         }
         g.sense_gain *= rng.uniform(1.0f - evo.mutation_sigma, 1.0f + evo.mutation_sigma);
         g.pheromone_gain *= rng.uniform(1.0f - evo.mutation_sigma, 1.0f + evo.mutation_sigma);
         g.exploration_bias = clamp01(g.exploration_bias + rng.uniform(-evo.exploration_delta, evo.exploration_delta));
     } else {
-        g = weighted_pick(entries);
+        g = weighted_pick(count);
         g.sense_gain *= rng.uniform(0.9f, 1.1f);
         g.pheromone_gain *= rng.uniform(0.9f, 1.1f);
         g.exploration_bias = clamp01(g.exploration_bias + rng.uniform(-0.05f, 0.05f));
@@ -74,8 +177,20 @@ Genome DNAMemory::sample(Rng &rng, const SimParams &params, const EvoParams &evo
 
 void DNAMemory::decay(const EvoParams &evo) {
     float decay = evo.enabled ? evo.age_decay : 0.995f;
-    for (auto &entry : entries) {
-        entry.age += 1;
-        entry.fitness *= decay;
+    epoch += 1;
+    fitness_scale *= std::max(0.0f, decay);
+    if (fitness_scale < kMinFitnessScale || fitness_scale > kMaxFitnessScale) {
+        for (auto &entry : entries) {
+            entry.raw_fitness *= fitness_scale;
+        }
+        fitness_scale = 1.0f;
+        weights_dirty = true;
     }
 }
+
+void DNAMemory::clear() {
+    entries.clear();
+    fitness_scale = 1.0f;
+    epoch = 0;
+    weights_dirty = true;
+}
@@ -11,10 +11,18 @@ struct Genome {
     float exploration_bias = 0.5f;
 };
 
+// raw_fitness ist relativ zu DNAMemory::fitness_scale gespeichert; effektive Werte liefert DNAMemory.
 struct DNAEntry {
+    Genome genome;
+    float raw_fitness = 0.0f;
+    int birth_step = 0;
+};
+
+// Vorgemerktes Genom fuer den Pool einer Spezies (fitness effektiv, nicht skaliert).
+struct DNACandidate {
     Genome genome;
     float fitness = 0.0f;
-    int age = 0;
+    int species = 0;
 };
 
 struct EvoParams {
@@ -26,10 +34,55 @@ struct EvoParams {
     float age_decay = 0.995f;
 };
 
+// Top-K-Pool: entries ist stets absteigend nach Fitness sortiert (entries.back() ist das schlechteste).
+// add() sortiert per Binaersuche ein und verdraengt bei vollem Pool das letzte Element.
+// Alterung ist O(1): decay() skaliert nur fitness_scale und zaehlt epoch hoch. raw * (d*d*...) rundet
+// anders als das fruehere ((f*d)*d)... je Eintrag; die Werte weichen im letzten Bit ab, die Reihenfolge
+// der Eintraege bleibt gleich.
 struct DNAMemory {
     std::vector<DNAEntry> entries;
+    float fitness_scale = 1.0f;
+    int epoch = 0;
 
-    void add(const SimParams &params, const Genome &genome, float fitness, const EvoParams &evo, int capacity_override = -1);
+    float fitness(const DNAEntry &entry) const { return entry.raw_fitness * fitness_scale; }
+    float worst_fitness() const { return fitness(entries.back()); }
+    int age(const DNAEntry &entry) const { return epoch - entry.birth_step; }
+
+    void add(const SimParams &params, const Genome &genome, float fitness, int capacity_override = -1);
+    // Alle Kandidaten der Spezies species auf einmal; gleiches Ergebnis wie add() fuer jeden in Listenreihenfolge.
+    void add_batch(const SimParams &params, const std::vector<DNACandidate> &candidates, int species,
+                   int capacity_override = -1);
     Genome sample(Rng &rng, const SimParams &params, const EvoParams &evo) const;
     void decay(const EvoParams &evo);
+    // Leert den Pool und setzt Skala und Epoche zurueck (Zustand wie frisch erzeugt).
+    void clear();
+
+    // Kumulierte Ziehungsgewichte max(0, fitness * dna_survival_bias + 0.01) ueber entries. Wird nur nach
+    // add(), geaenderter Skala oder Poolgroesse neu aufgebaut; nicht threadsicher.
+    const std::vector<float> &cumulative_weights(const SimParams &params) const;
+
+private:
+    mutable std::vector<float> cumulative;
+    mutable float weights_bias = 0.0f;
+    mutable float weights_scale = 0.0f;
+    mutable bool weights_dirty = true;
+
+    struct StagedEntry {
+        float raw_fitness;
+        int index;
+    };
+    std::vector<StagedEntry> staged;
+    std::vector<DNAEntry> merged;
+};
+
+// Gewichtete Auswahl per Binaersuche in den kumulierten Gewichten des Pools (ganzer Pool und Elite),
+// ohne Allokation. Gleiche Verteilung wie die lineare Suche mit pick -= w; durch andere Rundung der
+// Summen kann eine einzelne Ziehung an Gewichtsgrenzen aber auf den Nachbarn fallen. Gilt, solange sich der Pool nicht aendert; fuer viele Ziehungen hintereinander (Respawn).
+struct DNASampler {
+    const DNAMemory *memory = nullptr;
+    const float *cumulative = nullptr;
+    int elite_count = 0;
+
+    void prepare(const DNAMemory &pool, const SimParams &params, const EvoParams &evo);
+    Genome sample(Rng &rng, const EvoParams &evo) const;
 };
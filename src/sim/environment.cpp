@@ -1,28 +1,92 @@
 #include "environment.h"
 
 #include <algorithm>
+#include <cmath>
 
-Environment::Environment(int w, int h) : resources(w, h, 0.0f), blocked(static_cast<size_t>(w) * h, 0), width(w), height(h) {}
+#include "thread_pool.h"
+
+Environment::Environment(int w, int h)
+    : resources(w, h, 0.0f),
+      width(w),
+      height(h),
+      mask_words((w + 63) / 64),
+      blocked_bits(static_cast<size_t>((w + 63) / 64) * h, 0),
+      regen_stamp(static_cast<size_t>(resources.tiles_x) * resources.tiles_y, 0) {
+    rebuild_free_spans();
+}
+
+void Environment::rebuild_free_spans() {
+    free_spans.clear();
+    span_offsets.assign(static_cast<size_t>(height) + 1, 0);
+    for (int y = 0; y < height; ++y) {
+        const uint64_t *bits = blocked_bits.data() + static_cast<size_t>(y) * mask_words;
+        int x = 0;
+        while (x < width) {
+            // Naechste freie Zelle ab x, dann die naechste blockierte dahinter (ganze Woerter ueberspringen).
+            while (x < width && ((bits[x >> 6] >> (x & 63)) == ~uint64_t{0} >> (x & 63))) {
+                x = (x | 63) + 1;
+            }
+            while (x < width && is_blocked(x, y)) {
+                ++x;
+            }
+            if (x >= width) {
+                break;
+            }
+            const int start = x;
+            while (x < width && (bits[x >> 6] >> (x & 63)) == 0) {
+                x = (x | 63) + 1;
+            }
+            while (x < width && !is_blocked(x, y)) {
+                ++x;
+            }
+            x = std::min(x, width);
+            free_spans.push_back(FreeSpan{start, x});
+        }
+        span_offsets[static_cast<size_t>(y) + 1] = static_cast<int>(free_spans.size());
+    }
+}
 
 void Environment::seed_resources(Rng &rng) {
     for (int y = 0; y < height; ++y) {
+        float *row = resources.row(y);
         for (int x = 0; x < width; ++x) {
             float v = rng.uniform(0.0f, 1.0f);
-            resources.at(x, y) = (v > 0.98f) ? rng.uniform(0.5f, 1.0f) : 0.0f;
+            row[x] = (v > 0.98f) ? rng.uniform(0.5f, 1.0f) : 0.0f;
         }
+        // Blockierte Zellen bleiben leer; die Zufallsfolge haengt nicht von der Maske ab.
+        int x = 0;
+        for (const FreeSpan *span = free_spans_begin(y); span != free_spans_end(y); ++span) {
+            std::fill(row + x, row + span->x0, 0.0f);
+            x = span->x1;
+        }
+        std::fill(row + x, row + width, 0.0f);
     }
+    resources.mark_all_active();
+    std::fill(regen_stamp.begin(), regen_stamp.end(), regen_clock);
 }
 
-void Environment::regenerate(const SimParams &params) {
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            if (!blocked.empty() && blocked[static_cast<size_t>(y) * width + x] != 0) {
-                continue;
-            }
-            float &cell = resources.at(x, y);
-            cell += params.resource_regen;
-            if (cell > params.resource_max) {
-                cell = params.resource_max;
+void Environment::regenerate(const SimParams &params, ThreadPool *pool) {
+    sync_regen_mode(params);
+    if (lazy) {
+        ++regen_clock;
+        return;
+    }
+    parallel_for(pool, 0, height, [&](int y0, int y1) {
+        regenerate_rows(params, y0, y1);
+    });
+    if (params.resource_regen != 0.0f) {
+        resources.mark_all_active();
+    }
+}
+
+void Environment::regenerate_rows(const SimParams &params, int y0, int y1) {
+    const float regen = params.resource_regen;
+    const float max_value = params.resource_max;
+    for (int y = y0; y < y1; ++y) {
+        float *row = resources.row(y);
+        for (const FreeSpan *span = free_spans_begin(y); span != free_spans_end(y); ++span) {
+            for (int x = span->x0; x < span->x1; ++x) {
+                row[x] = std::min(row[x] + regen, max_value);
             }
         }
     }
@@ -39,26 +103,143 @@ void Environment::apply_block_rect(int x, int y, int w, int h) {
     for (int yy = y0; yy < y1; ++yy) {
         for (int xx = x0; xx < x1; ++xx) {
             resources.at(xx, yy) = 0.0f;
-            if (!blocked.empty()) {
-                blocked[static_cast<size_t>(yy) * width + xx] = 1;
-            }
+            blocked_bits[static_cast<size_t>(yy) * mask_words + (xx >> 6)] |= uint64_t{1} << (xx & 63);
         }
     }
+    rebuild_free_spans();
 }
 
-void Environment::shift_hotspots(int dx, int dy) {
+void Environment::shift_hotspots(int dx, int dy, ThreadPool *pool) {
     if (width <= 0 || height <= 0) {
         return;
     }
-    std::vector<float> next(resources.data.size(), 0.0f);
-    int sx = ((dx % width) + width) % width;
-    int sy = ((dy % height) + height) % height;
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            int nx = (x + sx) % width;
-            int ny = (y + sy) % height;
-            next[static_cast<size_t>(ny) * width + nx] = resources.at(x, y);
+    materialize_all();
+    const GridView next = resources.back_view();
+    const int sx = ((dx % width) + width) % width;
+    const int sy = ((dy % height) + height) % height;
+    // Zeilenweise Rotation in den Rueckpuffer: je Zeile zwei zusammenhaengende Kopien.
+    parallel_for(pool, 0, height, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const float *src = resources.row(y);
+            const int ny = (y + sy < height) ? y + sy : y + sy - height;
+            float *dst = next.row(ny);
+            std::copy(src, src + (width - sx), dst + sx);
+            std::copy(src + (width - sx), src + width, dst);
         }
+    });
+    resources.swap_buffers();
+    resources.mark_all_active();
+}
+
+void Environment::sync_regen_mode(const SimParams &params) {
+    if (params.resource_lazy_regen) {
+        if (lazy && (lazy_rate != params.resource_regen || lazy_max != params.resource_max)) {
+            materialize_all();
+        }
+        lazy = true;
+        lazy_rate = params.resource_regen;
+        lazy_max = params.resource_max;
+    } else if (lazy) {
+        materialize_all();
+        lazy = false;
+    }
+}
+
+void Environment::catch_up_span(int y, int x0, int x1, int steps, const float *src, float *dst) const {
+    if (steps <= 0) {
+        if (src != dst) {
+            std::copy(src + x0, src + x1, dst + x0);
+        }
+        return;
+    }
+    // Wie `steps` Aufrufe von regenerate_rows, aber in einem Schritt (nicht bitgleich zur Summe).
+    const float add = static_cast<float>(steps) * lazy_rate;
+    const float max_value = lazy_max;
+    if (src != dst) {
+        std::copy(src + x0, src + x1, dst + x0);
+    }
+    for (const FreeSpan *span = free_spans_begin(y); span != free_spans_end(y); ++span) {
+        const int xs = std::max(x0, span->x0);
+        const int xe = std::min(x1, span->x1);
+        for (int x = xs; x < xe; ++x) {
+            dst[x] = std::min(src[x] + add, max_value);
+        }
+    }
+}
+
+void Environment::materialize_tile(int tx, int ty) {
+    const int pending = pending_steps(tx, ty);
+    if (pending <= 0) {
+        return;
+    }
+    const int tile = GridField::kActiveTile;
+    const int x1 = std::min(width, (tx + 1) * tile);
+    const int y1 = std::min(height, (ty + 1) * tile);
+    for (int y = ty * tile; y < y1; ++y) {
+        float *row = resources.row(y);
+        catch_up_span(y, tx * tile, x1, pending, row, row);
+    }
+    regen_stamp[resources.tile_index(tx, ty)] = regen_clock;
+    if (lazy_rate != 0.0f) {
+        resources.mark_active(tx * tile, ty * tile);
+    }
+}
+
+void Environment::materialize_all() {
+    if (!lazy) {
+        return;
+    }
+    for (int ty = 0; ty < resources.tiles_y; ++ty) {
+        for (int tx = 0; tx < resources.tiles_x; ++tx) {
+            materialize_tile(tx, ty);
+        }
+    }
+}
+
+void Environment::materialize_rect(int x0, int y0, int x1, int y1) {
+    x0 = std::max(0, x0);
+    y0 = std::max(0, y0);
+    x1 = std::min(width, x1);
+    y1 = std::min(height, y1);
+    if (!lazy || x0 >= x1 || y0 >= y1) {
+        return;
+    }
+    const int tile = GridField::kActiveTile;
+    for (int ty = y0 / tile; ty <= (y1 - 1) / tile; ++ty) {
+        for (int tx = x0 / tile; tx <= (x1 - 1) / tile; ++tx) {
+            materialize_tile(tx, ty);
+        }
+    }
+}
+
+void Environment::materialize_around(float x, float y, float radius) {
+    if (!lazy || !(radius >= 0.0f) || !std::isfinite(x) || !std::isfinite(y)) {
+        materialize_all();
+        return;
+    }
+    const float r = std::min(radius, static_cast<float>(width + height));
+    materialize_rect(static_cast<int>(std::floor(x - r)) - 1, static_cast<int>(std::floor(y - r)) - 1,
+                     static_cast<int>(std::floor(x + r)) + 2, static_cast<int>(std::floor(y + r)) + 2);
+}
+
+const float *Environment::resource_row(int y, int x0, int x1, const float *stored, float *scratch) const {
+    if (!lazy || y < 0 || y >= height) {
+        return stored;
+    }
+    const int tile = GridField::kActiveTile;
+    const int ty = y / tile;
+    bool pending = false;
+    for (int tx = x0 / tile; tx <= (x1 - 1) / tile && !pending; ++tx) {
+        pending = pending_steps(tx, ty) > 0;
+    }
+    if (!pending) {
+        return stored;
+    }
+    float *out = scratch + 1;
+    for (int tx = x0 / tile; tx <= (x1 - 1) / tile; ++tx) {
+        const int xs = std::max(x0, tx * tile);
+        const int xe = std::min(x1, (tx + 1) * tile);
+        catch_up_span(y, xs, xe, pending_steps(tx, ty), stored, out);
     }
-    resources.data.swap(next);
+    return out;
 }
@@ -7,9 +7,22 @@
 #include <cstdint>
 #include <vector>
 
+class ThreadPool;
+
+// Freier Abschnitt [x0, x1) einer Rasterzeile (keine blockierten Zellen).
+struct FreeSpan {
+    int x0 = 0;
+    int x1 = 0;
+};
+
+// Ressourcenfeld mit Hindernismaske. Die Maske ist ein Bitset (64 Zellen je Wort, Zeilen auf
+// Wortgrenze); dazu pro Zeile die Liste der freien Abschnitte, damit Kernel ohne Maskentest
+// ueber zusammenhaengende Bereiche laufen. Im Lazy-Modus (SimParams::resource_lazy_regen) zaehlt
+// regenerate() nur einen Takt hoch; jede Kachel merkt sich den Takt ihres letzten Stands und
+// holt die ausstehenden n Schritte beim Lesen als min(v + n * regen, max) nach. Direkte Zugriffe
+// auf `resources` muessen vorher materialize_*() aufrufen (Mycel liest ueber resource_row()).
 struct Environment {
     GridField resources;
-    std::vector<uint8_t> blocked;
     int width = 0;
     int height = 0;
 
@@ -17,7 +30,44 @@ struct Environment {
     Environment(int w, int h);
 
     void seed_resources(Rng &rng);
-    void regenerate(const SimParams &params);
+    void regenerate(const SimParams &params, ThreadPool *pool = nullptr);
+    // Ohne Pflege der Aktivitaetsflags; der Aufrufer markiert danach (siehe regenerate).
+    void regenerate_rows(const SimParams &params, int y0, int y1);
     void apply_block_rect(int x, int y, int w, int h);
-    void shift_hotspots(int dx, int dy);
+    void shift_hotspots(int dx, int dy, ThreadPool *pool = nullptr);
+
+    bool is_blocked(int x, int y) const {
+        return (blocked_bits[static_cast<size_t>(y) * mask_words + (x >> 6)] >> (x & 63)) & 1u;
+    }
+    const FreeSpan *free_spans_begin(int y) const { return free_spans.data() + span_offsets[y]; }
+    const FreeSpan *free_spans_end(int y) const { return free_spans.data() + span_offsets[y + 1]; }
+
+    // Uebernimmt den Modus aus params; beim Wechsel (oder neuer Rate) wird Ausstehendes nachgeholt.
+    void sync_regen_mode(const SimParams &params);
+    bool lazy_regen() const { return lazy; }
+    void materialize_all();
+    void materialize_rect(int x0, int y0, int x1, int y1);
+    // Vor einem Agentenschritt: alle Kacheln, die der Agent lesen oder ernten kann.
+    void materialize_around(float x, float y, float radius);
+    // Logische Werte der Zeile y in [x0, x1): `stored` ist die gespeicherte Zeile; steht fuer
+    // eine Kachel Regeneration aus, wird nach `scratch` (width + 2 Floats) gerechnet.
+    const float *resource_row(int y, int x0, int x1, const float *stored, float *scratch) const;
+
+private:
+    int pending_steps(int tx, int ty) const { return regen_clock - regen_stamp[resources.tile_index(tx, ty)]; }
+    void materialize_tile(int tx, int ty);
+    void catch_up_span(int y, int x0, int x1, int steps, const float *src, float *dst) const;
+    void rebuild_free_spans();
+
+    int mask_words = 0;
+    std::vector<uint64_t> blocked_bits;
+    // Abschnitte aller Zeilen hintereinander; Zeile y belegt [span_offsets[y], span_offsets[y + 1]).
+    std::vector<FreeSpan> free_spans;
+    std::vector<int> span_offsets;
+
+    bool lazy = false;
+    int regen_clock = 0;
+    float lazy_rate = 0.0f;
+    float lazy_max = 0.0f;
+    std::vector<int> regen_stamp;
 };
@@ -2,52 +2,509 @@
 
 #include <algorithm>
 
-GridField::GridField(int w, int h, float value) : width(w), height(h), data(w * h, value) {}
+#include "thread_pool.h"
 
-float &GridField::at(int x, int y) {
-    return data[y * width + x];
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MICRO_SWARM_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MICRO_SWARM_SIMD_SSE2 1
+#endif
+
+namespace {
+const int kTileWidth = 256;
+const int kTileHeight = 64;
+const int kMaxBlockSteps = 8;
+
+struct DiffuseWeights {
+    float center;
+    float side;
+    float keep;
+};
+
+void diffuse_edge_span(const float *src, float *dst, int x0, int x1, const DiffuseWeights &w) {
+    for (int x = x0; x < x1; ++x) {
+        dst[x] = std::max(0.0f, src[x] * w.keep);
+    }
+}
+
+// Rechnet exakt in derselben Reihenfolge wie die skalare Referenz
+// (center, links, rechts, oben, unten), damit SIMD und Skalar bitgleich bleiben.
+void diffuse_interior_span(const float *up, const float *mid, const float *down, float *dst, int x0, int x1, const DiffuseWeights &w) {
+    int x = x0;
+#if defined(MICRO_SWARM_SIMD_AVX2)
+    const __m256 c8 = _mm256_set1_ps(w.center);
+    const __m256 s8 = _mm256_set1_ps(w.side);
+    const __m256 k8 = _mm256_set1_ps(w.keep);
+    const __m256 z8 = _mm256_setzero_ps();
+    for (; x + 8 <= x1; x += 8) {
+        __m256 sum = _mm256_mul_ps(_mm256_loadu_ps(mid + x), c8);
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(mid + x - 1), s8));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(mid + x + 1), s8));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(up + x), s8));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(down + x), s8));
+        _mm256_storeu_ps(dst + x, _mm256_max_ps(_mm256_mul_ps(sum, k8), z8));
+    }
+#endif
+#if defined(MICRO_SWARM_SIMD_AVX2) || defined(MICRO_SWARM_SIMD_SSE2)
+    const __m128 c4 = _mm_set1_ps(w.center);
+    const __m128 s4 = _mm_set1_ps(w.side);
+    const __m128 k4 = _mm_set1_ps(w.keep);
+    const __m128 z4 = _mm_setzero_ps();
+    for (; x + 4 <= x1; x += 4) {
+        __m128 sum = _mm_mul_ps(_mm_loadu_ps(mid + x), c4);
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(mid + x - 1), s4));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(mid + x + 1), s4));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(up + x), s4));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(down + x), s4));
+        _mm_storeu_ps(dst + x, _mm_max_ps(_mm_mul_ps(sum, k4), z4));
+    }
+#endif
+    for (; x < x1; ++x) {
+        float sum = mid[x] * w.center;
+        sum += mid[x - 1] * w.side;
+        sum += mid[x + 1] * w.side;
+        sum += up[x] * w.side;
+        sum += down[x] * w.side;
+        dst[x] = std::max(0.0f, sum * w.keep);
+    }
+}
+
+void diffuse_row_span(const float *up, const float *mid, const float *down, bool edge_row, int width,
+                      float *out, int x0, int x1, const DiffuseWeights &w) {
+    if (edge_row || width < 3) {
+        diffuse_edge_span(mid, out, x0, x1, w);
+        return;
+    }
+    if (x0 == 0) {
+        diffuse_edge_span(mid, out, 0, 1, w);
+        x0 = 1;
+    }
+    if (x1 == width) {
+        diffuse_edge_span(mid, out, width - 1, width, w);
+        x1 = width - 1;
+    }
+    if (x0 < x1) {
+        diffuse_interior_span(up, mid, down, out, x0, x1, w);
+    }
+}
+
+bool any_nonzero(const float *values, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (values[i] != 0.0f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const uint8_t kTileNonzero = 1;
+const uint8_t kTileComputed = 2;
+
+float *scratch_rows(const GridField &field, int rows) {
+    if (field.precision() == FieldPrecision::Float32) {
+        return nullptr;
+    }
+    return row_scratch(static_cast<size_t>(rows) * static_cast<size_t>(field.width + 2));
+}
+
+// Eine Kachelzeile: Kacheln ohne aktive Nachbarschaft bleiben 0 (der Rueckpuffer wird nur
+// geleert, wenn er dort noch Werte haelt), alle anderen werden gerechnet und neu bewertet.
+void diffuse_tile_row(GridField &field, uint8_t *next_active, int ty, const DiffuseWeights &w) {
+    const int tile = GridField::kActiveTile;
+    const int y0 = ty * tile;
+    const int y1 = std::min(field.height, y0 + tile);
+    for (int tx = 0; tx < field.tiles_x; ++tx) {
+        uint8_t &flag = next_active[field.tile_index(tx, ty)];
+        if (field.tile_or_neighbor_active(tx, ty)) {
+            flag = kTileComputed;
+        } else if (flag != 0) {
+            const int x0 = tx * tile;
+            const int x1 = std::min(field.width, x0 + tile);
+            for (int y = y0; y < y1; ++y) {
+                field.clear_back_span(y, x0, x1);
+            }
+            flag = 0;
+        }
+    }
+
+    // Drei rotierende Eingabezeilen: Zeile y liegt in Puffer (y - y0 + 1) % 3.
+    const size_t row_floats = static_cast<size_t>(field.width + 2);
+    float *scratch = scratch_rows(field, 4);
+    float *scratch_in[3] = {scratch, scratch ? scratch + row_floats : nullptr, scratch ? scratch + 2 * row_floats : nullptr};
+    float *scratch_out = scratch ? scratch + 3 * row_floats : nullptr;
+    const uint8_t *tile_flags = next_active + field.tile_index(0, ty);
+    const float *up = read_flagged_row(field, tile_flags, field.tiles_x, y0 - 1, scratch_in[0]);
+    const float *mid = read_flagged_row(field, tile_flags, field.tiles_x, y0, scratch_in[1]);
+    for (int y = y0; y < y1; ++y) {
+        const bool edge_row = (y == 0 || y == field.height - 1);
+        const float *down = read_flagged_row(field, tile_flags, field.tiles_x, y + 1, scratch_in[(y - y0 + 2) % 3]);
+        float *out = field.back_row(y, scratch_out);
+        for (int tx = 0; tx < field.tiles_x; ++tx) {
+            uint8_t &flag = next_active[field.tile_index(tx, ty)];
+            if (flag == 0) {
+                continue;
+            }
+            const int x0 = tx * tile;
+            const int x1 = std::min(field.width, x0 + tile);
+            diffuse_row_span(up, mid, down, edge_row, field.width, out, x0, x1, w);
+            field.commit_back_row(y, x0, x1, out);
+            if (!(flag & kTileNonzero) && any_nonzero(out + x0, x1 - x0)) {
+                flag |= kTileNonzero;
+            }
+        }
+        up = mid;
+        mid = down;
+    }
+    for (int tx = 0; tx < field.tiles_x; ++tx) {
+        next_active[field.tile_index(tx, ty)] &= kTileNonzero;
+    }
+}
+
+DiffuseWeights make_weights(const FieldParams &params) {
+    return DiffuseWeights{1.0f - params.diffusion, params.diffusion * 0.25f, 1.0f - params.evaporation};
+}
+
+struct TileBuffers {
+    std::vector<float> cur;
+    std::vector<float> nxt;
+};
+
+// Kachelpuffer fuer advance_tile, pro Thread einmal angelegt und wiederverwendet (wie row_scratch).
+TileBuffers &tile_buffers() {
+    thread_local TileBuffers buffers;
+    return buffers;
+}
+
+// Rundet Werte wie ein Schreib-/Lesezyklus eines fp16-Felds (gleiche Konvertierung wie commit_back_row).
+void round_span_to_half(float *values, int count) {
+    uint16_t bits[64];
+    for (int i = 0; i < count; i += 64) {
+        const int n = std::min(64, count - i);
+        float_to_half_span(values + i, bits, n);
+        half_to_float_span(bits, values + i, n);
+    }
+}
+
+// Rechnet eine Kachel [tx0,tx1) x [ty0,ty1) um `steps` Schritte weiter. Die Kachel wird mit
+// einem Halo von `steps` Zellen geladen; pro Schritt schrumpft der gueltige Bereich um eine
+// Zelle an jeder inneren Kante (ueberlappende Kacheln statt Trapez-Abhaengigkeiten).
+// Bei fp16 wird nach jedem Schritt auf half gerundet, wie im Einzelschritt ueber den Rueckpuffer.
+void advance_tile(GridField &field, int tx0, int ty0, int tx1, int ty1, int steps, const DiffuseWeights &w,
+                  std::vector<float> &cur, std::vector<float> &nxt, float *scratch) {
+    const int width = field.width;
+    const int height = field.height;
+    const int lx0 = std::max(0, tx0 - steps);
+    const int lx1 = std::min(width, tx1 + steps);
+    const int ly0 = std::max(0, ty0 - steps);
+    const int ly1 = std::min(height, ty1 + steps);
+    const int lw = lx1 - lx0;
+    const bool half = field.precision() != FieldPrecision::Float32;
+    const size_t count = static_cast<size_t>(lw) * static_cast<size_t>(ly1 - ly0);
+    cur.resize(count);
+    nxt.resize(count);
+    for (int y = ly0; y < ly1; ++y) {
+        const float *row = field.read_row(y, lx0, lx1, scratch);
+        std::copy(row + lx0, row + lx1, cur.data() + static_cast<size_t>(y - ly0) * lw);
+    }
+
+    for (int s = 1; s <= steps; ++s) {
+        const int vx0 = (lx0 == 0) ? 0 : lx0 + s;
+        const int vx1 = (lx1 == width) ? width : lx1 - s;
+        const int vy0 = (ly0 == 0) ? 0 : ly0 + s;
+        const int vy1 = (ly1 == height) ? height : ly1 - s;
+        for (int y = vy0; y < vy1; ++y) {
+            const float *row = cur.data() + static_cast<size_t>(y - ly0) * lw;
+            float *out = nxt.data() + static_cast<size_t>(y - ly0) * lw;
+            int a = vx0 - lx0;
+            int b = vx1 - lx0;
+            if (y == 0 || y == height - 1) {
+                diffuse_edge_span(row, out, a, b, w);
+                continue;
+            }
+            if (vx0 == 0) {
+                diffuse_edge_span(row, out, 0, 1, w);
+                a = 1;
+            }
+            if (vx1 == width) {
+                diffuse_edge_span(row, out, width - 1 - lx0, width - lx0, w);
+                b = width - 1 - lx0;
+            }
+            if (a < b) {
+                diffuse_interior_span(row - lw, row, row + lw, out, a, b, w);
+            }
+        }
+        if (half) {
+            for (int y = vy0; y < vy1; ++y) {
+                round_span_to_half(nxt.data() + static_cast<size_t>(y - ly0) * lw + (vx0 - lx0), vx1 - vx0);
+            }
+        }
+        std::swap(cur, nxt);
+    }
+
+    for (int y = ty0; y < ty1; ++y) {
+        const float *row = cur.data() + static_cast<size_t>(y - ly0) * lw;
+        float *out = field.back_row(y, scratch);
+        std::copy(row + (tx0 - lx0), row + (tx1 - lx0), out + tx0);
+        field.commit_back_row(y, tx0, tx1, out);
+    }
 }
+} // namespace
 
-float GridField::at(int x, int y) const {
-    return data[y * width + x];
+GridField::GridField(int w, int h, float value, int min_stride) : width(w), height(h) {
+    const int padded = std::max(w + 1, min_stride);
+    stride = (padded + kRowAlign - 1) / kRowAlign * kRowAlign;
+    const size_t total = origin_offset() + static_cast<size_t>(stride) * static_cast<size_t>(h + 1);
+    storage.assign(total, 0.0f);
+    back.assign(total, 0.0f);
+    tiles_x = (w + kActiveTile - 1) / kActiveTile;
+    tiles_y = (h + kActiveTile - 1) / kActiveTile;
+    active.assign(static_cast<size_t>(tiles_x) * tiles_y, 1);
+    back_active.assign(active.size(), 0);
+    fill(value);
+    mark_all_active();
+}
+
+void GridField::set_precision(FieldPrecision precision) {
+    const bool to_half = precision == FieldPrecision::Float16;
+    if (to_half == half || width <= 0 || height <= 0) {
+        half = to_half;
+        return;
+    }
+    const size_t total = origin_offset() + static_cast<size_t>(stride) * static_cast<size_t>(height + 1);
+    if (to_half) {
+        half_storage.assign(total, 0);
+        half_back.assign(total, 0);
+        for (int y = 0; y < height; ++y) {
+            float_to_half_span(row(y), half_row(y), width);
+        }
+        Storage().swap(storage);
+        Storage().swap(back);
+    } else {
+        storage.assign(total, 0.0f);
+        back.assign(total, 0.0f);
+        for (int y = 0; y < height; ++y) {
+            half_to_float_span(half_row(y), row(y), width);
+        }
+        HalfStorage().swap(half_storage);
+        HalfStorage().swap(half_back);
+    }
+    half = to_half;
+    std::fill(back_active.begin(), back_active.end(), 0);
+}
+
+const float *GridField::read_row(int y, int x0, int x1, float *scratch) const {
+    if (!half) {
+        return row(y);
+    }
+    const int lo = std::max(-1, x0 - 1);
+    const int hi = std::min(width + 1, x1 + 1);
+    half_to_float_span(half_row(y) + lo, scratch + 1 + lo, hi - lo);
+    return scratch + 1;
+}
+
+const float *GridField::read_back_row(int y, int x0, int x1, float *scratch) const {
+    if (!half) {
+        return back.data() + origin_offset() + static_cast<std::ptrdiff_t>(y) * stride;
+    }
+    const int lo = std::max(-1, x0 - 1);
+    const int hi = std::min(width + 1, x1 + 1);
+    half_to_float_span(half_back_row(y) + lo, scratch + 1 + lo, hi - lo);
+    return scratch + 1;
+}
+
+float *GridField::back_row(int y, float *scratch) {
+    if (!half) {
+        return back.data() + origin_offset() + static_cast<std::ptrdiff_t>(y) * stride;
+    }
+    return scratch + 1;
+}
+
+void GridField::commit_back_row(int y, int x0, int x1, const float *values) {
+    if (half) {
+        float_to_half_span(values + x0, half_back_row(y) + x0, x1 - x0);
+    }
+}
+
+void GridField::clear_back_span(int y, int x0, int x1) {
+    if (half) {
+        std::fill(half_back_row(y) + x0, half_back_row(y) + x1, static_cast<uint16_t>(0));
+    } else {
+        float *out = back_row(y, nullptr);
+        std::fill(out + x0, out + x1, 0.0f);
+    }
 }
 
 void GridField::fill(float value) {
-    std::fill(data.begin(), data.end(), value);
+    if (half) {
+        const uint16_t h = float_to_half(value);
+        for (int y = 0; y < height; ++y) {
+            std::fill(half_row(y), half_row(y) + width, h);
+        }
+    } else {
+        for (int y = 0; y < height; ++y) {
+            std::fill(row(y), row(y) + width, value);
+        }
+    }
+    std::fill(active.begin(), active.end(), value != 0.0f ? 1 : 0);
 }
 
-void diffuse_and_evaporate(GridField &field, const FieldParams &params) {
-    std::vector<float> next(field.data.size(), 0.0f);
-    const float diff = params.diffusion;
-    const float evap = params.evaporation;
+void GridField::copy_to(float *dst) const {
+    for (int y = 0; y < height; ++y) {
+        if (half) {
+            half_to_float_span(half_row(y), dst, width);
+        } else {
+            std::copy(row(y), row(y) + width, dst);
+        }
+        dst += width;
+    }
+}
 
-    for (int y = 0; y < field.height; ++y) {
-        for (int x = 0; x < field.width; ++x) {
-            float center = field.at(x, y);
-            float sum = center * (1.0f - diff);
-            int count = 0;
+void GridField::copy_from(const float *src) {
+    for (int y = 0; y < height; ++y) {
+        if (half) {
+            float_to_half_span(src, half_row(y), width);
+        } else {
+            std::copy(src, src + width, row(y));
+        }
+        src += width;
+    }
+    mark_all_active();
+}
 
-            auto add = [&](int nx, int ny) {
-                if (nx < 0 || ny < 0 || nx >= field.width || ny >= field.height) {
-                    return;
-                }
-                sum += field.at(nx, ny) * (diff * 0.25f);
-                count++;
-            };
+void GridField::mark_all_active() {
+    std::fill(active.begin(), active.end(), 1);
+}
 
-            add(x - 1, y);
-            add(x + 1, y);
-            add(x, y - 1);
-            add(x, y + 1);
+bool GridField::assign(const std::vector<float> &values) {
+    if (values.size() != cell_count()) {
+        return false;
+    }
+    copy_from(values.data());
+    return true;
+}
 
-            float value = sum;
-            if (count < 4) {
-                value = center;
+std::vector<float> GridField::to_vector() const {
+    std::vector<float> values(cell_count());
+    copy_to(values.data());
+    return values;
+}
+
+GridView GridField::back_view() {
+    return GridView{back_row(0, nullptr), width, height, stride};
+}
+
+void GridField::swap_buffers() {
+    storage.swap(back);
+    half_storage.swap(half_back);
+    active.swap(back_active);
+}
+
+float *row_scratch(size_t count) {
+    thread_local std::vector<float> scratch;
+    if (scratch.size() < count) {
+        scratch.resize(count);
+    }
+    return scratch.data();
+}
+
+const float *read_flagged_row(const GridField &field, const uint8_t *tile_flags, int tiles_x, int y, float *scratch,
+                              bool from_back) {
+    if (field.precision() == FieldPrecision::Float32) {
+        return from_back ? field.read_back_row(y, 0, field.width, scratch) : field.read_row(y, 0, field.width, scratch);
+    }
+    const int tile = GridField::kActiveTile;
+    for (int tx = 0; tx < tiles_x; ++tx) {
+        if (tile_flags[tx] == 0) {
+            continue;
+        }
+        // Benachbarte Kacheln zusammenfassen, damit die Spannen am Stueck konvertiert werden.
+        int tx_end = tx + 1;
+        while (tx_end < tiles_x && tile_flags[tx_end] != 0) {
+            ++tx_end;
+        }
+        const int x1 = std::min(field.width, tx_end * tile);
+        if (from_back) {
+            field.read_back_row(y, tx * tile, x1, scratch);
+        } else {
+            field.read_row(y, tx * tile, x1, scratch);
+        }
+        tx = tx_end;
+    }
+    return scratch + 1;
+}
+
+void diffuse_and_evaporate(GridField &field, const FieldParams &params, ThreadPool *pool) {
+    uint8_t *next_active = field.back_activity();
+    const DiffuseWeights w = make_weights(params);
+    parallel_for(pool, 0, field.tiles_y, [&](int t0, int t1) {
+        for (int ty = t0; ty < t1; ++ty) {
+            diffuse_tile_row(field, next_active, ty, w);
+        }
+    });
+    field.swap_buffers();
+}
+
+void diffuse_and_evaporate_tile_row(GridField &field, const FieldParams &params, int ty) {
+    diffuse_tile_row(field, field.back_activity(), ty, make_weights(params));
+}
+
+void diffuse_and_evaporate_fused(GridField &a, const FieldParams &pa,
+                                 GridField &b, const FieldParams &pb,
+                                 GridField &c, const FieldParams &pc,
+                                 ThreadPool *pool) {
+    const bool same_shape = a.width == b.width && a.width == c.width &&
+                            a.height == b.height && a.height == c.height;
+    if (!same_shape) {
+        diffuse_and_evaporate(a, pa, pool);
+        diffuse_and_evaporate(b, pb, pool);
+        diffuse_and_evaporate(c, pc, pool);
+        return;
+    }
+
+    GridField *fields[3] = {&a, &b, &c};
+    const DiffuseWeights weights[3] = {make_weights(pa), make_weights(pb), make_weights(pc)};
+    uint8_t *next_active[3] = {a.back_activity(), b.back_activity(), c.back_activity()};
+
+    parallel_for(pool, 0, a.tiles_y, [&](int t0, int t1) {
+        for (int ty = t0; ty < t1; ++ty) {
+            for (int i = 0; i < 3; ++i) {
+                diffuse_tile_row(*fields[i], next_active[i], ty, weights[i]);
             }
-            value *= (1.0f - evap);
-            next[y * field.width + x] = std::max(0.0f, value);
         }
+    });
+
+    for (int i = 0; i < 3; ++i) {
+        fields[i]->swap_buffers();
     }
+}
 
-    field.data.swap(next);
+void diffuse_and_evaporate_steps(GridField &field, const FieldParams &params, int steps, ThreadPool *pool) {
+    if (steps <= 0 || field.width <= 0 || field.height <= 0) {
+        return;
+    }
+    const int width = field.width;
+    const int height = field.height;
+    const DiffuseWeights w = make_weights(params);
+    const int tiles_x = (width + kTileWidth - 1) / kTileWidth;
+    const int tiles_y = (height + kTileHeight - 1) / kTileHeight;
+
+    while (steps > 0) {
+        const int block = std::min(steps, kMaxBlockSteps);
+        parallel_for(pool, 0, tiles_x * tiles_y, [&](int t0, int t1) {
+            TileBuffers &buffers = tile_buffers();
+            float *scratch = scratch_rows(field, 1);
+            for (int t = t0; t < t1; ++t) {
+                const int tx0 = (t % tiles_x) * kTileWidth;
+                const int ty0 = (t / tiles_x) * kTileHeight;
+                const int tx1 = std::min(width, tx0 + kTileWidth);
+                const int ty1 = std::min(height, ty0 + kTileHeight);
+                advance_tile(field, tx0, ty0, tx1, ty1, block, w, buffers.cur, buffers.nxt, scratch);
+            }
+        });
+        field.swap_buffers();
+        field.mark_all_active();
+        steps -= block;
+    }
 }
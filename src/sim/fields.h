@@ -1,24 +1,172 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <new>
 #include <vector>
 
+#include "half.h"
+
+class ThreadPool;
+
+// Allokator fuer Feldspeicher: Bloecke beginnen auf einer 64-Byte-Grenze (Cache-Zeile).
+template <typename T>
+struct AlignedAllocator {
+    using value_type = T;
+    static constexpr std::size_t kAlignment = 64;
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U> &) {}
+
+    T *allocate(std::size_t n) {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(kAlignment)));
+    }
+    void deallocate(T *ptr, std::size_t) {
+        ::operator delete(ptr, std::align_val_t(kAlignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U> &) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U> &) const { return false; }
+};
+
+// Nicht-besitzende Sicht auf ein Feld. (0,0) ist die erste Zelle; die Geisterzellen
+// bei x=-1, x=width, y=-1 und y=height sind ebenfalls adressierbar.
+template <typename T>
+struct BasicGridView {
+    T *origin = nullptr;
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+
+    T *row(int y) const { return origin + static_cast<std::ptrdiff_t>(y) * stride; }
+    T &at(int x, int y) const { return row(y)[x]; }
+};
+
+using GridView = BasicGridView<float>;
+using ConstGridView = BasicGridView<const float>;
+
+enum class FieldPrecision {
+    Float32,
+    Float16
+};
+
+// Zeilen beginnen 64-Byte-ausgerichtet im Abstand `stride` (Vielfaches von 16 Floats,
+// mindestens width + 1). Um das Feld liegt ein Rand aus Geisterzellen, der immer 0 bleibt.
+// Der Speicher ist damit nicht dicht; dichte width*height-Kopien ueber copy_to/copy_from.
+//
+// Zusaetzlich fuehrt das Feld pro Kachel (kActiveTile x kActiveTile) ein Aktivitaetsflag fuer
+// Vorder- und Rueckpuffer: 0 heisst "alle Zellen sind 0". Wer ueber at()/row() Werte ungleich 0
+// schreibt, muss mark_active()/mark_all_active() aufrufen; die Kernel pflegen die Flags selbst.
+//
+// Optional liegt das Feld als fp16 vor (halber Speicher). Dann gelten row()/at()/view() nicht;
+// Zugriffe laufen ueber get/set/add bzw. read_row/back_row, gerechnet wird immer in float32.
 struct GridField {
+    using Storage = std::vector<float, AlignedAllocator<float>>;
+    using HalfStorage = std::vector<uint16_t, AlignedAllocator<uint16_t>>;
+    static constexpr int kRowAlign = 16;
+    static constexpr int kActiveTile = 32;
+
     int width = 0;
     int height = 0;
-    std::vector<float> data;
+    int stride = 0;
+    int tiles_x = 0;
+    int tiles_y = 0;
 
     GridField() = default;
-    GridField(int w, int h, float value = 0.0f);
+    GridField(int w, int h, float value = 0.0f, int min_stride = 0);
+
+    float *row(int y) { return storage.data() + origin_offset() + static_cast<std::ptrdiff_t>(y) * stride; }
+    const float *row(int y) const { return storage.data() + origin_offset() + static_cast<std::ptrdiff_t>(y) * stride; }
+    float &at(int x, int y) { return row(y)[x]; }
+    float at(int x, int y) const { return row(y)[x]; }
+
+    FieldPrecision precision() const { return half ? FieldPrecision::Float16 : FieldPrecision::Float32; }
+    void set_precision(FieldPrecision precision);
+    float get(int x, int y) const { return half ? half_to_float(half_row(y)[x]) : at(x, y); }
+    void set(int x, int y, float value) {
+        if (half) {
+            half_row(y)[x] = float_to_half(value);
+        } else {
+            at(x, y) = value;
+        }
+    }
+    void add(int x, int y, float value) { set(x, y, get(x, y) + value); }
 
-    float &at(int x, int y);
-    float at(int x, int y) const;
+    // Zeile y als float32, gueltig fuer die Spalten [x0 - 1, x1]: bei float32 direkt der
+    // Feldspeicher, bei fp16 nach `scratch` (mindestens width + 2 Floats) konvertiert.
+    const float *read_row(int y, int x0, int x1, float *scratch) const;
+    // Wie read_row, aber aus dem Rueckpuffer (Kernel-Ergebnis vor swap_buffers()).
+    const float *read_back_row(int y, int x0, int x1, float *scratch) const;
+    // Zielzeile im Rueckpuffer; bei fp16 ein Zwischenpuffer, den commit_back_row zurueckschreibt.
+    float *back_row(int y, float *scratch);
+    void commit_back_row(int y, int x0, int x1, const float *values);
+    void clear_back_span(int y, int x0, int x1);
+
+    GridView view() { return GridView{row(0), width, height, stride}; }
+    ConstGridView view() const { return ConstGridView{row(0), width, height, stride}; }
+    ConstGridView const_view() const { return view(); }
+    std::size_t cell_count() const { return static_cast<std::size_t>(width) * static_cast<std::size_t>(height); }
 
     void fill(float value);
+    void copy_to(float *dst) const;
+    void copy_from(const float *src);
+    bool assign(const std::vector<float> &values);
+    std::vector<float> to_vector() const;
+
+    void mark_active(int x, int y) { active[tile_index(x / kActiveTile, y / kActiveTile)] = 1; }
+    void mark_all_active();
+    bool tile_active(int tx, int ty) const { return active[tile_index(tx, ty)] != 0; }
+    bool back_tile_active(int tx, int ty) const { return back_active[tile_index(tx, ty)] != 0; }
+    bool tile_or_neighbor_active(int tx, int ty) const {
+        return tile_active(tx, ty) ||
+               (tx > 0 && tile_active(tx - 1, ty)) || (tx + 1 < tiles_x && tile_active(tx + 1, ty)) ||
+               (ty > 0 && tile_active(tx, ty - 1)) || (ty + 1 < tiles_y && tile_active(tx, ty + 1));
+    }
+    std::size_t tile_index(int tx, int ty) const { return static_cast<std::size_t>(ty) * tiles_x + tx; }
+
+    GridView back_view();
+    uint8_t *back_activity() { return back_active.data(); }
+    void swap_buffers();
+
+private:
+    std::size_t origin_offset() const { return static_cast<std::size_t>(stride) + kRowAlign; }
+    uint16_t *half_row(int y) { return half_storage.data() + origin_offset() + static_cast<std::ptrdiff_t>(y) * stride; }
+    const uint16_t *half_row(int y) const { return half_storage.data() + origin_offset() + static_cast<std::ptrdiff_t>(y) * stride; }
+    uint16_t *half_back_row(int y) { return half_back.data() + origin_offset() + static_cast<std::ptrdiff_t>(y) * stride; }
+    const uint16_t *half_back_row(int y) const { return half_back.data() + origin_offset() + static_cast<std::ptrdiff_t>(y) * stride; }
+
+    bool half = false;
+    Storage storage;
+    Storage back;
+    HalfStorage half_storage;
+    HalfStorage half_back;
+    std::vector<uint8_t> active;
+    std::vector<uint8_t> back_active;
 };
 
+// Pro Thread wiederverwendeter Puffer fuer Zeilenkonvertierungen (fp16-Felder).
+float *row_scratch(std::size_t count);
+// read_row (bzw. read_back_row) fuer alle Kacheln einer Kachelzeile mit tile_flags[tx] != 0
+// (tiles_x Eintraege); so wird jede fp16-Zeile pro Kachelzeile nur einmal konvertiert.
+const float *read_flagged_row(const GridField &field, const uint8_t *tile_flags, int tiles_x, int y, float *scratch,
+                              bool from_back = false);
+
 struct FieldParams {
     float evaporation = 0.0f;
     float diffusion = 0.0f;
 };
 
-void diffuse_and_evaporate(GridField &field, const FieldParams &params);
+void diffuse_and_evaporate(GridField &field, const FieldParams &params, ThreadPool *pool = nullptr);
+void diffuse_and_evaporate_fused(GridField &a, const FieldParams &pa,
+                                 GridField &b, const FieldParams &pb,
+                                 GridField &c, const FieldParams &pc,
+                                 ThreadPool *pool = nullptr);
+// Eine Kachelzeile von diffuse_and_evaporate in den Rueckpuffer; nach allen Zeilen swap_buffers().
+void diffuse_and_evaporate_tile_row(GridField &field, const FieldParams &params, int ty);
+// Wie `steps` Aufrufe von diffuse_and_evaporate (bitgleich, bei fp16 durch Rundung nach jedem
+// Schritt), aber kachelweise mit zeitlichem Blocking: das Feld wird nur einmal pro Block von bis
+// zu 8 Schritten gestreamt.
+void diffuse_and_evaporate_steps(GridField &field, const FieldParams &params, int steps, ThreadPool *pool = nullptr);
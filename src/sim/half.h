@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#include <immintrin.h>
+#define MICRO_SWARM_F16C 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MICRO_SWARM_HALF_SSE2 1
+#endif
+
+// IEEE-754 binary16 <-> float32, Rundung zur naechsten geraden Zahl (wie F16C).
+// Ohne Verzweigungen, damit die Span-Schleifen auch ohne F16C vektorisiert werden.
+// Subnormale laufen ueber eine float-Addition mit passend skalierter Konstante; das
+// setzt die Standard-Rundung voraus (kein -ffast-math/FTZ).
+inline uint32_t half_float_bits(float value) {
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float half_bits_float(uint32_t bits) {
+    float value = 0.0f;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline uint16_t float_to_half(float value) {
+    const uint32_t bits = half_float_bits(value);
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t abs = bits & 0x7fffffffu;
+    const uint32_t special = abs > 0x7f800000u ? (0x7e00u | ((abs & 0x7fffffu) >> 13)) : 0x7c00u;
+    const uint32_t subnormal = half_float_bits(half_bits_float(abs) + 0.5f) - 0x3f000000u;
+    const uint32_t normal = (abs + 0xc8000fffu + ((abs >> 13) & 1u)) >> 13;
+    const uint32_t half = abs >= 0x47800000u ? special : (abs < 0x38800000u ? subnormal : normal);
+    return static_cast<uint16_t>(half | sign);
+}
+
+inline float half_to_float(uint16_t half) {
+    const uint32_t bits = static_cast<uint32_t>(half & 0x7fffu) << 13;
+    const uint32_t exponent = bits & 0x0f800000u;
+    const uint32_t special = (bits + 0x70000000u) | ((bits & 0x7fffffu) != 0 ? 0x400000u : 0u);
+    const uint32_t subnormal = half_float_bits(half_bits_float(bits + 0x38800000u) - 6.103515625e-05f);
+    const uint32_t normal = bits + 0x38000000u;
+    const uint32_t result = exponent == 0x0f800000u ? special : (exponent == 0 ? subnormal : normal);
+    return half_bits_float(result | (static_cast<uint32_t>(half & 0x8000u) << 16));
+}
+
+#if defined(MICRO_SWARM_HALF_SSE2)
+// Dieselben Formeln wie float_to_half/half_to_float, vier Werte je Register.
+inline __m128i half_select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+inline __m128 half_to_float4(__m128i half) {
+    const __m128i bits = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x7fff)), 13);
+    const __m128i exponent = _mm_and_si128(bits, _mm_set1_epi32(0x0f800000));
+    const __m128i mantissa_zero = _mm_cmpeq_epi32(_mm_and_si128(bits, _mm_set1_epi32(0x7fffff)), _mm_setzero_si128());
+    const __m128i special = _mm_or_si128(_mm_add_epi32(bits, _mm_set1_epi32(0x70000000)),
+                                         _mm_andnot_si128(mantissa_zero, _mm_set1_epi32(0x400000)));
+    const __m128i subnormal = _mm_castps_si128(_mm_sub_ps(
+        _mm_castsi128_ps(_mm_add_epi32(bits, _mm_set1_epi32(0x38800000))), _mm_set1_ps(6.103515625e-05f)));
+    const __m128i normal = _mm_add_epi32(bits, _mm_set1_epi32(0x38000000));
+    __m128i result = half_select(_mm_cmpeq_epi32(exponent, _mm_setzero_si128()), subnormal, normal);
+    result = half_select(_mm_cmpeq_epi32(exponent, _mm_set1_epi32(0x0f800000)), special, result);
+    return _mm_castsi128_ps(_mm_or_si128(result, _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x8000)), 16)));
+}
+
+inline __m128i float_to_half4(__m128 value) {
+    const __m128i bits = _mm_castps_si128(value);
+    const __m128i sign = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x8000));
+    const __m128i abs = _mm_and_si128(bits, _mm_set1_epi32(0x7fffffff));
+    const __m128i special = half_select(_mm_cmpgt_epi32(abs, _mm_set1_epi32(0x7f800000)),
+                                        _mm_or_si128(_mm_set1_epi32(0x7e00),
+                                                     _mm_srli_epi32(_mm_and_si128(abs, _mm_set1_epi32(0x7fffff)), 13)),
+                                        _mm_set1_epi32(0x7c00));
+    const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(abs), _mm_set1_ps(0.5f))),
+                                            _mm_set1_epi32(0x3f000000));
+    const __m128i odd = _mm_and_si128(_mm_srli_epi32(abs, 13), _mm_set1_epi32(1));
+    const __m128i normal = _mm_srli_epi32(
+        _mm_add_epi32(_mm_add_epi32(abs, _mm_set1_epi32(static_cast<int>(0xc8000fffu))), odd), 13);
+    __m128i half = half_select(_mm_cmplt_epi32(abs, _mm_set1_epi32(0x38800000)), subnormal, normal);
+    half = half_select(_mm_cmpgt_epi32(abs, _mm_set1_epi32(0x477fffff)), special, half);
+    return _mm_or_si128(half, sign);
+}
+#endif
+
+inline void half_to_float_span(const uint16_t *src, float *dst, int count) {
+    int i = 0;
+#if defined(MICRO_SWARM_F16C)
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+#elif defined(MICRO_SWARM_HALF_SSE2)
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_ps(dst + i, half_to_float4(_mm_unpacklo_epi16(h, _mm_setzero_si128())));
+        _mm_storeu_ps(dst + i + 4, half_to_float4(_mm_unpackhi_epi16(h, _mm_setzero_si128())));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = half_to_float(src[i]);
+    }
+}
+
+inline void float_to_half_span(const float *src, uint16_t *dst, int count) {
+    int i = 0;
+#if defined(MICRO_SWARM_F16C)
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), h);
+    }
+#elif defined(MICRO_SWARM_HALF_SSE2)
+    for (; i + 8 <= count; i += 8) {
+        // packs_epi32 saettigt vorzeichenbehaftet; die 16-Bit-Werte vorher vorzeichenerweitern.
+        __m128i lo = _mm_srai_epi32(_mm_slli_epi32(float_to_half4(_mm_loadu_ps(src + i)), 16), 16);
+        __m128i hi = _mm_srai_epi32(_mm_slli_epi32(float_to_half4(_mm_loadu_ps(src + i + 4)), 16), 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packs_epi32(lo, hi));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = float_to_half(src[i]);
+    }
+}
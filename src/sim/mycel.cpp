@@ -1,55 +1,149 @@
 #include "mycel.h"
 
 #include <algorithm>
+#include <cmath>
+
+#include "thread_pool.h"
 
 MycelNetwork::MycelNetwork(int w, int h) : density(w, h, 0.0f), width(w), height(h) {}
 
-void MycelNetwork::update(const SimParams &params, const GridField &pheromone, const GridField &resources) {
-    std::vector<float> next(density.data.size(), 0.0f);
+namespace {
+const uint8_t kTileNonzero = 1;
+const uint8_t kTileComputed = 2;
+} // namespace
+
+void MycelNetwork::update(const SimParams &params, const GridField &pheromone, const Environment &env, ThreadPool *pool) {
+    parallel_for(pool, 0, density.tiles_y, [&](int t0, int t1) {
+        for (int ty = t0; ty < t1; ++ty) {
+            update_tile_row(params, pheromone, false, env, ty);
+        }
+    });
+    density.swap_buffers();
+}
+
+void MycelNetwork::update_tile_row(const SimParams &params, const GridField &pheromone, bool pheromone_in_back,
+                                   const Environment &env, int ty) {
+    const GridField &resources = env.resources;
+    uint8_t *next_active = density.back_activity();
+    const int tile = GridField::kActiveTile;
 
     auto clamp01 = [](float v) {
         return std::max(0.0f, std::min(1.0f, v));
     };
+    auto drive_of = [&](float local_pheromone, float local_resource) {
+        float drive = params.mycel_drive_p * local_pheromone + params.mycel_drive_r * local_resource;
+        return clamp01(drive);
+    };
+
+    // Eine Kachel bleibt exakt 0, wenn Dichte (inkl. Nachbarkacheln) und Pheromon dort 0 sind
+    // und der Antrieb allein aus den Ressourcen nirgends die Schwelle ueberschreitet.
+    const bool same_tiles = pheromone.width == width && pheromone.height == height;
+    const bool finite_rates = std::isfinite(params.mycel_growth) && std::isfinite(params.mycel_transport) &&
+                              std::isfinite(params.mycel_decay) && std::isfinite(params.mycel_drive_p);
+    const bool need_scratch = density.precision() != FieldPrecision::Float32 ||
+                              pheromone.precision() != FieldPrecision::Float32 ||
+                              resources.precision() != FieldPrecision::Float32 || env.lazy_regen();
+    const size_t row_floats = static_cast<size_t>(width + 2);
+
+    auto tile_stays_zero = [&](int tx, float *scratch, float *scratch_lazy) {
+        if (!same_tiles || !finite_rates || density.tile_or_neighbor_active(tx, ty) ||
+            (pheromone_in_back ? pheromone.back_tile_active(tx, ty) : pheromone.tile_active(tx, ty))) {
+            return false;
+        }
+        const int x1 = std::min(width, (tx + 1) * tile);
+        const int y1 = std::min(height, (ty + 1) * tile);
+        for (int y = ty * tile; y < y1; ++y) {
+            const float *resource_row =
+                env.resource_row(y, tx * tile, x1, resources.read_row(y, tx * tile, x1, scratch), scratch_lazy);
+            for (int x = tx * tile; x < x1; ++x) {
+                if (drive_of(0.0f, resource_row[x]) > params.mycel_drive_threshold) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
 
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            float current = density.at(x, y);
-            float local_pheromone = pheromone.at(x, y);
-            float local_resource = resources.at(x, y);
-
-            float drive = params.mycel_drive_p * local_pheromone + params.mycel_drive_r * local_resource;
-            drive = clamp01(drive);
-            float threshold = params.mycel_drive_threshold;
-            if (drive > threshold) {
-                drive = (drive - threshold) / (1.0f - threshold);
-            } else {
-                drive = 0.0f;
+    const int band_y0 = ty * tile;
+    const int band_y1 = std::min(height, band_y0 + tile);
+    float *scratch = need_scratch ? row_scratch(7 * row_floats) : nullptr;
+    float *scratch_density[3] = {scratch, scratch ? scratch + row_floats : nullptr,
+                                 scratch ? scratch + 2 * row_floats : nullptr};
+    float *scratch_pheromone = scratch ? scratch + 3 * row_floats : nullptr;
+    float *scratch_resource = scratch ? scratch + 4 * row_floats : nullptr;
+    float *scratch_out = scratch ? scratch + 5 * row_floats : nullptr;
+    float *scratch_lazy = scratch ? scratch + 6 * row_floats : nullptr;
+    for (int tx = 0; tx < density.tiles_x; ++tx) {
+        uint8_t &flag = next_active[density.tile_index(tx, ty)];
+        if (!tile_stays_zero(tx, scratch_resource, scratch_lazy)) {
+            flag = kTileComputed;
+        } else if (flag != 0) {
+            const int x0 = tx * tile;
+            const int x1 = std::min(width, x0 + tile);
+            for (int y = band_y0; y < band_y1; ++y) {
+                density.clear_back_span(y, x0, x1);
             }
+            flag = 0;
+        }
+    }
 
-            float neighbor_sum = 0.0f;
-            int neighbor_count = 0;
-            auto add = [&](int nx, int ny) {
-                if (nx < 0 || ny < 0 || nx >= width || ny >= height) {
-                    return;
+    const uint8_t *tile_flags = next_active + density.tile_index(0, ty);
+    const float *up = read_flagged_row(density, tile_flags, density.tiles_x, band_y0 - 1, scratch_density[0]);
+    const float *row = read_flagged_row(density, tile_flags, density.tiles_x, band_y0, scratch_density[1]);
+    for (int y = band_y0; y < band_y1; ++y) {
+        const float *down = read_flagged_row(density, tile_flags, density.tiles_x, y + 1,
+                                             scratch_density[(y - band_y0 + 2) % 3]);
+        const float *pheromone_row =
+            read_flagged_row(pheromone, tile_flags, density.tiles_x, y, scratch_pheromone, pheromone_in_back);
+        const float *resource_row = read_flagged_row(resources, tile_flags, density.tiles_x, y, scratch_resource);
+        float *out = density.back_row(y, scratch_out);
+        const int row_edges = (y == 0 ? 1 : 0) + (y == height - 1 ? 1 : 0);
+        for (int tx = 0; tx < density.tiles_x; ++tx) {
+            uint8_t &flag = next_active[density.tile_index(tx, ty)];
+            if (flag == 0) {
+                continue;
+            }
+            const int x0 = tx * tile;
+            const int x1 = std::min(width, x0 + tile);
+            const float *tile_resources = env.resource_row(y, x0, x1, resource_row, scratch_lazy);
+            bool nonzero = false;
+            for (int x = x0; x < x1; ++x) {
+                float current = row[x];
+                float drive = drive_of(pheromone_row[x], tile_resources[x]);
+                float threshold = params.mycel_drive_threshold;
+                if (drive > threshold) {
+                    drive = (drive - threshold) / (1.0f - threshold);
+                } else {
+                    drive = 0.0f;
                 }
-                neighbor_sum += density.at(nx, ny);
-                neighbor_count++;
-            };
-
-            add(x - 1, y);
-            add(x + 1, y);
-            add(x, y - 1);
-            add(x, y + 1);
-
-            float neighbor_avg = (neighbor_count > 0) ? (neighbor_sum / static_cast<float>(neighbor_count)) : current;
-            float transport = params.mycel_transport * (neighbor_avg - current);
-            float growth = params.mycel_growth * drive * (1.0f - current);
-            float decay = params.mycel_decay * current;
-
-            float value = current + growth + transport - decay;
-            next[y * width + x] = clamp01(value);
+
+                // Geisterzellen sind 0 und aendern die Summe nicht; nur die Anzahl zaehlt die Raender.
+                float neighbor_sum = 0.0f;
+                neighbor_sum += row[x - 1];
+                neighbor_sum += row[x + 1];
+                neighbor_sum += up[x];
+                neighbor_sum += down[x];
+                int neighbor_count = 4 - row_edges - (x == 0 ? 1 : 0) - (x == width - 1 ? 1 : 0);
+
+                float neighbor_avg = (neighbor_count > 0) ? (neighbor_sum / static_cast<float>(neighbor_count)) : current;
+                float transport = params.mycel_transport * (neighbor_avg - current);
+                float growth = params.mycel_growth * drive * (1.0f - current);
+                float decay = params.mycel_decay * current;
+
+                float value = current + growth + transport - decay;
+                out[x] = clamp01(value);
+                nonzero |= out[x] != 0.0f;
+            }
+            density.commit_back_row(y, x0, x1, out);
+            if (nonzero) {
+                flag |= kTileNonzero;
+            }
         }
+        up = row;
+        row = down;
     }
 
-    density.data.swap(next);
+    for (int tx = 0; tx < density.tiles_x; ++tx) {
+        next_active[density.tile_index(tx, ty)] &= kTileNonzero;
+    }
 }
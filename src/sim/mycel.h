@@ -1,8 +1,11 @@
 #pragma once
 
+#include "environment.h"
 #include "fields.h"
 #include "params.h"
 
+class ThreadPool;
+
 struct MycelNetwork {
     GridField density;
     int width = 0;
@@ -11,5 +14,10 @@ struct MycelNetwork {
     MycelNetwork() = default;
     MycelNetwork(int w, int h);
 
-    void update(const SimParams &params, const GridField &pheromone, const GridField &resources);
+    // Ressourcen kommen aus env (inkl. ausstehender Lazy-Regeneration, ohne sie zu schreiben).
+    void update(const SimParams &params, const GridField &pheromone, const Environment &env, ThreadPool *pool = nullptr);
+    // Eine Kachelzeile von update() in den Rueckpuffer schreiben; danach density.swap_buffers().
+    // pheromone_in_back liest das Pheromon aus dessen Rueckpuffer (noch nicht getauschter Diffusionsschritt).
+    void update_tile_row(const SimParams &params, const GridField &pheromone, bool pheromone_in_back,
+                         const Environment &env, int ty);
 };
@@ -15,6 +15,8 @@ struct SimParams {
 
     float resource_regen = 0.0015f;
     float resource_max = 1.0f;
+    // Regeneration erst beim Lesen in geschlossener Form nachholen (pro Kachel Zeitstempel).
+    bool resource_lazy_regen = false;
 
     float mycel_decay = 0.003f;
     float mycel_growth = 0.02f;
@@ -28,6 +30,14 @@ struct SimParams {
     float agent_deposit_scale = 0.8f;
     float agent_sense_radius = 2.5f;
     float agent_random_turn = 0.2f;
+    // Ab diesem Sensorradius wird auf groben Pyramidenstufen abgetastet (je Verdopplung eine Stufe); 0 = aus.
+    float agent_sense_lod_radius = 0.0f;
+    // Agentenphase parallel mit Deposit-Puffern (andere, aber reproduzierbare Ergebnisse).
+    bool agent_parallel = false;
+    // Richtungen als 16-Bit-Binaerwinkel, cos/sin aus Tabelle (statistisch gleichwertig, nicht bitgleich).
+    bool agent_fast_steering = false;
+    // Alle N Schritte Agenten nach Morton-Code ihrer Zelle umsortieren (Cache-Lokalitaet); 0 = aus.
+    int agent_sort_interval = 0;
 
     int dna_capacity = 256;
     int dna_global_capacity = 128;
@@ -0,0 +1,91 @@
+#include "pyramid.h"
+
+#include <algorithm>
+
+#include "thread_pool.h"
+
+namespace {
+// Stufen bis hierhin liegen kachelweise innerhalb der kActiveTile-Kacheln von Stufe 0.
+const int kTileLevels = 5;
+
+// Zeile y einer Stufe (0 = Quellfeld) als float32 fuer die Spalten [x0, x1).
+const float *level_row(const GridField &field, const std::vector<GridField> &levels, int k, int y, int x0, int x1,
+                       float *scratch) {
+    if (k == 0) {
+        return field.read_row(y, x0, x1, scratch);
+    }
+    return levels[static_cast<size_t>(k) - 1].row(y);
+}
+
+// Zellen [x0,x1) x [y0,y1) der Stufe k aus Stufe k - 1. Kinder ausserhalb liegen auf dem
+// Geisterrand (0) und zaehlen nicht mit.
+void reduce_region(const GridField &field, std::vector<GridField> &levels, int k, int x0, int y0, int x1, int y1,
+                   float *scratch) {
+    GridField &dst = levels[static_cast<size_t>(k) - 1];
+    const int child_w = k == 1 ? field.width : levels[static_cast<size_t>(k) - 2].width;
+    const int child_h = k == 1 ? field.height : levels[static_cast<size_t>(k) - 2].height;
+    const size_t row_floats = static_cast<size_t>(child_w + 2);
+    float *scratch_top = scratch;
+    float *scratch_bottom = scratch ? scratch + row_floats : nullptr;
+    for (int y = y0; y < y1; ++y) {
+        const float *top = level_row(field, levels, k - 1, 2 * y, 2 * x0, 2 * x1, scratch_top);
+        const float *bottom = level_row(field, levels, k - 1, 2 * y + 1, 2 * x0, 2 * x1, scratch_bottom);
+        const float rows = (2 * y + 1 < child_h) ? 2.0f : 1.0f;
+        float *out = dst.row(y);
+        for (int x = x0; x < x1; ++x) {
+            const float cols = (2 * x + 1 < child_w) ? 2.0f : 1.0f;
+            const float sum = top[2 * x] + top[2 * x + 1] + bottom[2 * x] + bottom[2 * x + 1];
+            out[x] = sum / (rows * cols);
+        }
+    }
+}
+} // namespace
+
+void FieldPyramid::update(const GridField &field, ThreadPool *pool) {
+    const size_t tile_count = static_cast<size_t>(field.tiles_x) * field.tiles_y;
+    if (field.width != width || field.height != height || built_active.size() != tile_count) {
+        width = field.width;
+        height = field.height;
+        levels.clear();
+        int w = width;
+        int h = height;
+        while (w > 1 || h > 1) {
+            w = (w + 1) / 2;
+            h = (h + 1) / 2;
+            levels.emplace_back(w, h, 0.0f);
+        }
+        built_active.assign(tile_count, 1);
+    }
+    if (levels.empty()) {
+        return;
+    }
+
+    const int tile = GridField::kActiveTile;
+    const int tile_levels = std::min(kTileLevels, static_cast<int>(levels.size()));
+    const bool half = field.precision() != FieldPrecision::Float32;
+    parallel_for(pool, 0, field.tiles_y, [&](int t0, int t1) {
+        float *scratch = half ? row_scratch(2 * static_cast<size_t>(field.width + 2)) : nullptr;
+        for (int ty = t0; ty < t1; ++ty) {
+            for (int tx = 0; tx < field.tiles_x; ++tx) {
+                uint8_t &built = built_active[field.tile_index(tx, ty)];
+                const bool active = field.tile_active(tx, ty);
+                if (!active && built == 0) {
+                    continue;
+                }
+                built = active ? 1 : 0;
+                for (int k = 1; k <= tile_levels; ++k) {
+                    const GridField &dst = levels[static_cast<size_t>(k) - 1];
+                    const int span = tile >> k;
+                    reduce_region(field, levels, k, tx * span, ty * span, std::min(dst.width, (tx + 1) * span),
+                                  std::min(dst.height, (ty + 1) * span), scratch);
+                }
+            }
+        }
+    });
+
+    // Grobe Stufen sind klein und werden immer komplett gerechnet.
+    for (int k = tile_levels + 1; k <= static_cast<int>(levels.size()); ++k) {
+        const GridField &dst = levels[static_cast<size_t>(k) - 1];
+        reduce_region(field, levels, k, 0, 0, dst.width, dst.height, nullptr);
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "fields.h"
+
+class ThreadPool;
+
+// Mip-Pyramide eines Feldes: Stufe k hat (width >> k) x (height >> k) Zellen (aufgerundet),
+// jede Zelle ist der Mittelwert ihrer bis zu 2x2 Kinder. Stufe 0 ist das Feld selbst.
+// update() rechnet nur Kacheln neu, die jetzt oder beim letzten Aufbau aktiv waren;
+// inaktive Kacheln sind 0 und ihre Pyramidenbereiche bleiben gueltig.
+struct FieldPyramid {
+    std::vector<GridField> levels;
+    std::vector<uint8_t> built_active;
+    int width = 0;
+    int height = 0;
+
+    void update(const GridField &field, ThreadPool *pool = nullptr);
+    int level_count() const { return 1 + static_cast<int>(levels.size()); }
+    // Nur fuer k >= 1; Stufe 0 ist das Quellfeld.
+    const GridField &level(int k) const { return levels[static_cast<size_t>(k) - 1]; }
+};
@@ -1,19 +1,79 @@
 #pragma once
 
-#include <random>
+#include <cstdint>
 
+// Bereich eines Zufallsstroms; gleiche (seed, id, step) in verschiedenen Bereichen sind unabhaengig.
+enum class RngDomain : uint32_t {
+    Global = 0,
+    AgentStep = 1,
+    Respawn = 2
+};
+
+// Zaehlerbasierter Generator (Philox4x32-10): jeder Wert ist eine reine Funktion von Schluessel
+// (seed, Bereich) und Zaehler (Ziehung, id, step). Rng(seed) ist ein fortlaufender Strom;
+// Rng::stream() liefert den Strom eines Agenten in einem Schritt, unabhaengig davon, in welcher
+// Reihenfolge oder auf welchem Thread die Agenten laufen.
 struct Rng {
-    std::mt19937 rng;
+    explicit Rng(uint32_t seed) : Rng(seed, RngDomain::Global, 0, 0) {}
 
-    explicit Rng(uint32_t seed) : rng(seed) {}
+    static Rng stream(uint32_t seed, RngDomain domain, uint32_t id, uint32_t step) {
+        return Rng(seed, domain, id, step);
+    }
+
+    uint32_t next_u32() {
+        if (pos == 4) {
+            refill();
+        }
+        return block[pos++];
+    }
 
+    // [a, b) mit 24 Bit Aufloesung.
     float uniform(float a = 0.0f, float b = 1.0f) {
-        std::uniform_real_distribution<float> dist(a, b);
-        return dist(rng);
+        const float u = static_cast<float>(next_u32() >> 8) * (1.0f / 16777216.0f);
+        return a + (b - a) * u;
     }
 
+    // [a, b], Multiplikation statt Modulo.
     int uniform_int(int a, int b) {
-        std::uniform_int_distribution<int> dist(a, b);
-        return dist(rng);
+        const uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(b) - static_cast<int64_t>(a)) + 1u;
+        return static_cast<int>(a + static_cast<int64_t>((static_cast<uint64_t>(next_u32()) * range) >> 32));
     }
+
+private:
+    Rng(uint32_t seed, RngDomain domain, uint32_t id, uint32_t step)
+        : key{seed, static_cast<uint32_t>(domain)}, ctr{0u, 0u, id, step} {}
+
+    void refill() {
+        uint32_t c0 = ctr[0];
+        uint32_t c1 = ctr[1];
+        uint32_t c2 = ctr[2];
+        uint32_t c3 = ctr[3];
+        uint32_t k0 = key[0];
+        uint32_t k1 = key[1];
+        for (int round = 0; round < 10; ++round) {
+            const uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0;
+            const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+            const uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+            const uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+            c1 = static_cast<uint32_t>(p1);
+            c3 = static_cast<uint32_t>(p0);
+            c0 = n0;
+            c2 = n2;
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        block[0] = c0;
+        block[1] = c1;
+        block[2] = c2;
+        block[3] = c3;
+        pos = 0;
+        if (++ctr[0] == 0u) {
+            ++ctr[1];
+        }
+    }
+
+    uint32_t key[2];
+    uint32_t ctr[4];
+    uint32_t block[4] = {};
+    int pos = 4;
 };
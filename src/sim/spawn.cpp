@@ -0,0 +1,143 @@
+#include "spawn.h"
+
+#include <algorithm>
+
+void stage_agents(AgentSoA &agents, std::size_t begin, std::size_t end, bool evo_enabled, float min_energy_to_store,
+                  StepStaging &out) {
+    for (std::size_t i = begin; i < end; ++i) {
+        if (evo_enabled) {
+            if (agents.energy[i] > min_energy_to_store) {
+                out.candidates.push_back({agents.genome(i), agents.fitness_value[i], agents.species[i]});
+                agents.energy[i] *= 0.6f;
+            }
+        } else {
+            if (agents.energy[i] > 1.2f) {
+                out.candidates.push_back({agents.genome(i), agents.energy[i], agents.species[i]});
+                agents.energy[i] *= 0.6f;
+            }
+        }
+        if (agents.energy[i] <= kRespawnEnergy) {
+            out.dead.push_back(static_cast<int>(i));
+        }
+    }
+}
+
+void stage_agents_parallel(AgentSoA &agents, bool evo_enabled, float min_energy_to_store, ThreadPool *pool,
+                           std::vector<StepStaging> &chunks, StepStaging &out) {
+    const std::size_t count = agents.size();
+    const int chunk_count = static_cast<int>((count + kParallelChunk - 1) / kParallelChunk);
+    while (chunks.size() < static_cast<std::size_t>(chunk_count)) {
+        chunks.emplace_back();
+        chunks.back().candidates.reserve(kParallelChunk);
+        chunks.back().dead.reserve(kParallelChunk);
+    }
+    parallel_for(pool, 0, chunk_count, [&](int c0, int c1) {
+        for (int chunk = c0; chunk < c1; ++chunk) {
+            const std::size_t begin = static_cast<std::size_t>(chunk) * kParallelChunk;
+            const std::size_t end = std::min(count, begin + kParallelChunk);
+            chunks[chunk].clear();
+            stage_agents(agents, begin, end, evo_enabled, min_energy_to_store, chunks[chunk]);
+        }
+    });
+    for (int chunk = 0; chunk < chunk_count; ++chunk) {
+        out.candidates.insert(out.candidates.end(), chunks[chunk].candidates.begin(), chunks[chunk].candidates.end());
+        out.dead.insert(out.dead.end(), chunks[chunk].dead.begin(), chunks[chunk].dead.end());
+    }
+}
+
+void merge_staged_dna(const StepStaging &staged, const SimParams &params, const EvoParams &evo,
+                      std::array<DNAMemory, 4> &dna_species, DNAMemory &dna_global) {
+    if (staged.candidates.empty()) {
+        return;
+    }
+    for (int s = 0; s < 4; ++s) {
+        dna_species[s].add_batch(params, staged.candidates, s, params.dna_capacity);
+    }
+    if (!evo.enabled || params.dna_global_capacity <= 0) {
+        return;
+    }
+    const float global_epsilon = 1e-6f;
+    for (const DNACandidate &c : staged.candidates) {
+        if (dna_global.entries.size() < static_cast<std::size_t>(params.dna_global_capacity) ||
+            c.fitness > dna_global.worst_fitness() + global_epsilon) {
+            dna_global.add(params, c.genome, c.fitness, params.dna_global_capacity);
+        }
+    }
+}
+
+int pick_species(Rng &rng, const std::array<float, 4> &fracs) {
+    float r = rng.uniform(0.0f, 1.0f);
+    float accum = 0.0f;
+    for (int i = 0; i < 4; ++i) {
+        accum += fracs[i];
+        if (r <= accum) {
+            return i;
+        }
+    }
+    return 3;
+}
+
+void clamp_genome(Genome &g) {
+    g.sense_gain = std::min(3.0f, std::max(0.2f, g.sense_gain));
+    g.pheromone_gain = std::min(3.0f, std::max(0.2f, g.pheromone_gain));
+    g.exploration_bias = std::min(1.0f, std::max(0.0f, g.exploration_bias));
+}
+
+void Spawner::prepare(const std::array<DNAMemory, 4> &dna_species, const DNAMemory &dna_global) {
+    for (int s = 0; s < 4; ++s) {
+        species_samplers[s].prepare(dna_species[s], *params, *evo);
+    }
+    global_sampler.prepare(dna_global, *params, *evo);
+}
+
+Genome Spawner::sample_genome(Rng &rng, int species) const {
+    const SpeciesProfile &profile = profiles[species];
+    bool use_dna = rng.uniform(0.0f, 1.0f) < profile.dna_binding;
+    Genome g;
+    if (use_dna) {
+        if (evo->enabled && !global_sampler.memory->entries.empty() && rng.uniform(0.0f, 1.0f) < global_spawn_frac) {
+            g = global_sampler.sample(rng, *evo);
+        } else {
+            g = species_samplers[species].sample(rng, *evo);
+        }
+    } else {
+        g.sense_gain = rng.uniform(0.6f, 1.4f);
+        g.pheromone_gain = rng.uniform(0.6f, 1.4f);
+        g.exploration_bias = rng.uniform(0.2f, 0.8f);
+    }
+    if (evo->enabled) {
+        float sigma = evo->mutation_sigma * profile.mutation_sigma_mul;
+        float delta = evo->exploration_delta * profile.exploration_delta_mul;
+        if (sigma > 0.0f) {
+            g.sense_gain *= rng.uniform(1.0f - sigma, 1.0f + sigma);
+            g.pheromone_gain *= rng.uniform(1.0f - sigma, 1.0f + sigma);
+        }
+        if (delta > 0.0f) {
+            g.exploration_bias += rng.uniform(-delta, delta);
+        }
+        clamp_genome(g);
+    }
+    return g;
+}
+
+Agent Spawner::spawn(Rng &rng, float energy_max) const {
+    Agent agent;
+    agent.x = static_cast<float>(rng.uniform_int(0, params->width - 1));
+    agent.y = static_cast<float>(rng.uniform_int(0, params->height - 1));
+    agent.heading = rng.uniform(0.0f, 6.283185307f);
+    agent.energy = rng.uniform(0.2f, energy_max);
+    agent.last_energy = agent.energy;
+    agent.fitness_accum = 0.0f;
+    agent.fitness_ticks = 0;
+    agent.fitness_value = 0.0f;
+    agent.species = pick_species(rng, *species_fracs);
+    agent.genome = sample_genome(rng, agent.species);
+    return agent;
+}
+
+void Spawner::respawn(AgentSoA &agents, const std::vector<int> &dead, uint32_t seed, uint32_t step) const {
+    for (int i : dead) {
+        Rng rng = Rng::stream(seed, RngDomain::Respawn, static_cast<uint32_t>(agents.id[i]), step);
+        agents.set(static_cast<std::size_t>(i), spawn(rng, 0.5f));
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "agent.h"
+#include "agent_soa.h"
+#include "dna_memory.h"
+#include "thread_pool.h"
+
+// Bis zu dieser Energie gilt ein Agent nach dem Schritt als tot und wird neu erzeugt.
+constexpr float kRespawnEnergy = 0.05f;
+
+// Nachbearbeitung eines Schritts, in Agentenreihenfolge gesammelt: Genome fuer die DNA-Pools und tote Agenten.
+struct StepStaging {
+    std::vector<DNACandidate> candidates;
+    std::vector<int> dead;
+
+    void clear() {
+        candidates.clear();
+        dead.clear();
+    }
+};
+
+// Agenten [begin, end): wer genug Energie hat, gibt sein Genom als Kandidat ab (Energie * 0.6), mit Evolution
+// ab min_energy_to_store und der Fitness, sonst ab 1.2 und der Energie. Danach werden Tote vorgemerkt.
+void stage_agents(AgentSoA &agents, std::size_t begin, std::size_t end, bool evo_enabled, float min_energy_to_store,
+                  StepStaging &out);
+
+// Wie stage_agents fuer alle Agenten, in Bloecken von kParallelChunk mit je eigenem Puffer; die Puffer werden
+// in Blockreihenfolge an out angehaengt.
+void stage_agents_parallel(AgentSoA &agents, bool evo_enabled, float min_energy_to_store, ThreadPool *pool,
+                           std::vector<StepStaging> &chunks, StepStaging &out);
+
+// Uebernimmt die Kandidaten in die Pools, mit demselben Ergebnis wie einzelnes Einfuegen in Agentenreihenfolge:
+// Speziespools per add_batch, der globale Pool (nur mit Evolution) nacheinander ueber das Tor
+// "Pool nicht voll oder besser als das schlechteste + 1e-6".
+void merge_staged_dna(const StepStaging &staged, const SimParams &params, const EvoParams &evo,
+                      std::array<DNAMemory, 4> &dna_species, DNAMemory &dna_global);
+
+int pick_species(Rng &rng, const std::array<float, 4> &fracs);
+void clamp_genome(Genome &g);
+
+// Erzeugt Agenten (Start und Respawn) aus den DNA-Pools. prepare() summiert die Poolgewichte einmal
+// vor; bis zum naechsten prepare() duerfen sich die Pools nicht aendern.
+struct Spawner {
+    const SimParams *params = nullptr;
+    const EvoParams *evo = nullptr;
+    const SpeciesProfile *profiles = nullptr;
+    const std::array<float, 4> *species_fracs = nullptr;
+    float global_spawn_frac = 0.0f;
+
+    void prepare(const std::array<DNAMemory, 4> &dna_species, const DNAMemory &dna_global);
+
+    // Agent an zufaelliger Zelle, Energie gleichverteilt in [0.2, energy_max).
+    Agent spawn(Rng &rng, float energy_max) const;
+
+    // Erzeugt die Agenten auf den Plaetzen dead neu, jeden aus Rng::stream(seed, Respawn, id, step).
+    void respawn(AgentSoA &agents, const std::vector<int> &dead, uint32_t seed, uint32_t step) const;
+
+private:
+    Genome sample_genome(Rng &rng, int species) const;
+
+    std::array<DNASampler, 4> species_samplers;
+    DNASampler global_sampler;
+};
@@ -0,0 +1,17 @@
+#include "steering.h"
+
+#include <cmath>
+
+namespace {
+std::array<SinCos, 1 << kSinCosBits> build_sin_cos_table() {
+    std::array<SinCos, 1 << kSinCosBits> table{};
+    const double step = 6.283185307179586 / static_cast<double>(table.size());
+    for (std::size_t i = 0; i < table.size(); ++i) {
+        table[i].c = static_cast<float>(std::cos(step * static_cast<double>(i)));
+        table[i].s = static_cast<float>(std::sin(step * static_cast<double>(i)));
+    }
+    return table;
+}
+} // namespace
+
+const std::array<SinCos, 1 << kSinCosBits> kSinCosTable = build_sin_cos_table();
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Binaerwinkel: 65536 Einheiten = 2 pi. Addition und Subtraktion laufen ueber uint16_t von selbst
+// um, wrap_angle entfaellt.
+using BinaryAngle = uint16_t;
+
+constexpr float kBinaryAnglePerRad = 65536.0f / 6.283185307f;
+constexpr float kRadPerBinaryAngle = 6.283185307f / 65536.0f;
+constexpr BinaryAngle kSensorOffsetAngle = 6258; // 0.6 rad
+constexpr BinaryAngle kHalfTurnAngle = 32768;
+
+struct SinCos {
+    float c;
+    float s;
+};
+
+// cos/sin in 4096 Stufen (Schrittweite 0.0015 rad); Index = naechste Stufe zum Binaerwinkel.
+constexpr int kSinCosBits = 12;
+extern const std::array<SinCos, 1 << kSinCosBits> kSinCosTable;
+
+// Naechster Binaerwinkel; beliebige (auch negative) Bogenmasswerte.
+inline BinaryAngle to_binary_angle(float rad) {
+    const float scaled = rad * kBinaryAnglePerRad;
+    const int32_t rounded = static_cast<int32_t>(scaled + (scaled >= 0.0f ? 0.5f : -0.5f));
+    return static_cast<BinaryAngle>(static_cast<uint32_t>(rounded));
+}
+
+inline float from_binary_angle(BinaryAngle angle) {
+    return static_cast<float>(angle) * kRadPerBinaryAngle;
+}
+
+inline const SinCos &sin_cos(BinaryAngle angle) {
+    constexpr int shift = 16 - kSinCosBits;
+    const uint32_t index = ((static_cast<uint32_t>(angle) + (1u << (shift - 1))) >> shift) & ((1u << kSinCosBits) - 1u);
+    return kSinCosTable[index];
+}
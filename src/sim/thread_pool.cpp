@@ -0,0 +1,145 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace {
+int resolve_thread_count(int threads) {
+    if (threads <= 0) {
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    return std::max(1, threads);
+}
+
+void band_of(int begin, int end, int index, int count, int &out_begin, int &out_end) {
+    const int64_t len = static_cast<int64_t>(end) - begin;
+    out_begin = begin + static_cast<int>(len * index / count);
+    out_end = begin + static_cast<int>(len * (index + 1) / count);
+}
+} // namespace
+
+ThreadPool::ThreadPool(int threads) {
+    start(resolve_thread_count(threads));
+}
+
+ThreadPool::ThreadPool(const ThreadPool &other) {
+    start(other.thread_count);
+}
+
+ThreadPool &ThreadPool::operator=(const ThreadPool &other) {
+    if (this != &other) {
+        set_threads(other.thread_count);
+    }
+    return *this;
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+void ThreadPool::set_threads(int threads) {
+    threads = resolve_thread_count(threads);
+    if (threads == thread_count && static_cast<int>(workers.size()) == threads - 1) {
+        return;
+    }
+    stop();
+    start(threads);
+}
+
+void ThreadPool::start(int threads) {
+    thread_count = threads;
+    stopping = false;
+    workers.reserve(static_cast<size_t>(threads - 1));
+    for (int i = 1; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::worker_loop, this, i, generation);
+    }
+}
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void ThreadPool::run(int begin, int end, Task fn, void *ctx) {
+    if (workers.empty()) {
+        fn(ctx, begin, end);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = fn;
+        task_ctx = ctx;
+        range_begin = begin;
+        range_end = end;
+        pending = static_cast<int>(workers.size());
+        generation += 1;
+    }
+    wake.notify_all();
+
+    // Die Worker lesen ctx aus dem Stack des Aufrufers: auch wenn das eigene Band wirft,
+    // erst auf sie warten und die Ausnahme danach weiterreichen.
+    std::exception_ptr error;
+    int b = 0;
+    int e = 0;
+    band_of(begin, end, 0, thread_count, b, e);
+    if (b < e) {
+        try {
+            fn(ctx, b, e);
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending == 0; });
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::worker_loop(int index, uint64_t seen) {
+    for (;;) {
+        Task fn = nullptr;
+        void *ctx = nullptr;
+        int begin = 0;
+        int end = 0;
+        int count = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            fn = task;
+            ctx = task_ctx;
+            begin = range_begin;
+            end = range_end;
+            count = thread_count;
+        }
+
+        int b = 0;
+        int e = 0;
+        band_of(begin, end, index, count, b, e);
+        if (b < e) {
+            fn(ctx, b, e);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending -= 1;
+            if (pending == 0) {
+                done.notify_one();
+            }
+        }
+    }
+}
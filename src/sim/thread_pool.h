@@ -0,0 +1,62 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Persistenter Worker-Pool fuer zeilenweise Feldkernel. Der Bereich wird in
+// zusammenhaengende Baender (ein Band pro Thread) geteilt; der Aufrufer rechnet
+// das erste Band selbst. Ein Dispatch allokiert nichts.
+class ThreadPool {
+public:
+    using Task = void (*)(void *ctx, int begin, int end);
+
+    explicit ThreadPool(int threads = 1);
+    ThreadPool(const ThreadPool &other);
+    ThreadPool &operator=(const ThreadPool &other);
+    ~ThreadPool();
+
+    void set_threads(int threads);
+    int threads() const { return thread_count; }
+
+    template <typename Fn>
+    void parallel_for(int begin, int end, Fn &&fn) {
+        using FnType = std::remove_reference_t<Fn>;
+        Task task = [](void *ctx, int b, int e) {
+            (*static_cast<FnType *>(ctx))(b, e);
+        };
+        run(begin, end, task, const_cast<void *>(static_cast<const void *>(&fn)));
+    }
+
+private:
+    void run(int begin, int end, Task task, void *ctx);
+    void start(int threads);
+    void stop();
+    void worker_loop(int index, uint64_t seen);
+
+    int thread_count = 1;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    Task task = nullptr;
+    void *task_ctx = nullptr;
+    int range_begin = 0;
+    int range_end = 0;
+    uint64_t generation = 0;
+    int pending = 0;
+    bool stopping = false;
+};
+
+// Fuehrt fn(begin, end) auf dem Pool aus oder, ohne Pool bzw. mit einem Thread, direkt.
+template <typename Fn>
+void parallel_for(ThreadPool *pool, int begin, int end, Fn &&fn) {
+    if (!pool || pool->threads() <= 1 || end - begin < 2) {
+        fn(begin, end);
+        return;
+    }
+    pool->parallel_for(begin, end, fn);
+}
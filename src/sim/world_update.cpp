@@ -0,0 +1,67 @@
+#include "world_update.h"
+
+#include <algorithm>
+
+#include "thread_pool.h"
+
+void world_update_fused(const SimParams &params,
+                        GridField &phero_food,
+                        GridField *phero_danger,
+                        GridField *molecules,
+                        MycelNetwork &mycel,
+                        Environment &env,
+                        ThreadPool *pool) {
+    const FieldParams pheromone_params{params.pheromone_evaporation, params.pheromone_diffusion};
+    const FieldParams molecule_params{params.molecule_evaporation, params.molecule_diffusion};
+    GridField *fields[3] = {&phero_food, phero_danger, molecules};
+    const FieldParams *field_params[3] = {&pheromone_params, &pheromone_params, &molecule_params};
+
+    bool same_shape = env.width == mycel.width && env.height == mycel.height;
+    for (GridField *field : fields) {
+        if (field) {
+            same_shape = same_shape && field->width == mycel.width && field->height == mycel.height;
+        }
+    }
+    if (!same_shape) {
+        for (int i = 0; i < 3; ++i) {
+            if (fields[i]) {
+                diffuse_and_evaporate(*fields[i], *field_params[i], pool);
+            }
+        }
+        mycel.update(params, phero_food, env, pool);
+        env.regenerate(params, pool);
+        return;
+    }
+
+    // Jede Kachelzeile liest nur die alten Vorderpuffer (plus eine Halo-Zeile) und schreibt in
+    // die Rueckpuffer; Mycel liest das neue Pheromon und die Ressourcen nur aus der eigenen
+    // Zeile, bevor diese regeneriert wird. Damit sind die Kachelzeilen unabhaengig.
+    const int tile = GridField::kActiveTile;
+    env.sync_regen_mode(params);
+    const bool eager_regen = !env.lazy_regen();
+    parallel_for(pool, 0, mycel.density.tiles_y, [&](int t0, int t1) {
+        for (int ty = t0; ty < t1; ++ty) {
+            for (int i = 0; i < 3; ++i) {
+                if (fields[i]) {
+                    diffuse_and_evaporate_tile_row(*fields[i], *field_params[i], ty);
+                }
+            }
+            mycel.update_tile_row(params, phero_food, true, env, ty);
+            if (eager_regen) {
+                env.regenerate_rows(params, ty * tile, std::min(env.height, (ty + 1) * tile));
+            }
+        }
+    });
+
+    for (GridField *field : fields) {
+        if (field) {
+            field->swap_buffers();
+        }
+    }
+    mycel.density.swap_buffers();
+    if (!eager_regen) {
+        env.regenerate(params, pool);
+    } else if (params.resource_regen != 0.0f) {
+        env.resources.mark_all_active();
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "environment.h"
+#include "fields.h"
+#include "mycel.h"
+#include "params.h"
+
+class ThreadPool;
+
+// Diffusion (Pheromon, optional Gefahr und Molekuele), Mycel-Update und Ressourcen-Regeneration
+// in einem Durchlauf ueber Kachelzeilen. Bitgleich zur Folge diffuse_and_evaporate_fused ->
+// MycelNetwork::update -> Environment::regenerate; nullptr-Felder werden nicht diffundiert.
+void world_update_fused(const SimParams &params,
+                        GridField &phero_food,
+                        GridField *phero_danger,
+                        GridField *molecules,
+                        MycelNetwork &mycel,
+                        Environment &env,
+                        ThreadPool *pool = nullptr);
@@ -0,0 +1,205 @@
+#include "micro_swarm_api.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what) {
+    if (!ok) {
+        std::printf("FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+ms_config_t make_config(int width, int height, int agents, uint32_t seed) {
+    ms_config_t cfg{};
+    ms_handle_t *defaults = ms_create(nullptr);
+    ms_get_params(defaults, &cfg.params);
+    ms_destroy(defaults);
+    cfg.params.width = width;
+    cfg.params.height = height;
+    cfg.params.agent_count = agents;
+    cfg.seed = seed;
+    return cfg;
+}
+
+std::vector<float> field(ms_handle_t *h, ms_field_kind kind) {
+    int w = 0;
+    int hgt = 0;
+    ms_get_field_info(h, kind, &w, &hgt);
+    std::vector<float> out(static_cast<size_t>(w) * hgt);
+    ms_copy_field_out(h, kind, out.data(), static_cast<int>(out.size()));
+    return out;
+}
+
+std::vector<ms_agent_t> agents(ms_handle_t *h) {
+    std::vector<ms_agent_t> out(ms_get_agent_count(h));
+    ms_get_agents(h, out.data(), static_cast<int>(out.size()));
+    return out;
+}
+
+bool same_bits(const void *a, const void *b, size_t bytes) {
+    return std::memcmp(a, b, bytes) == 0;
+}
+
+// Felder und Agenten bitgenau vergleichen.
+bool same_state(ms_handle_t *a, ms_handle_t *b) {
+    for (int k = MS_FIELD_RESOURCES; k <= MS_FIELD_MYCEL; ++k) {
+        const std::vector<float> fa = field(a, static_cast<ms_field_kind>(k));
+        const std::vector<float> fb = field(b, static_cast<ms_field_kind>(k));
+        if (fa.size() != fb.size() || !same_bits(fa.data(), fb.data(), fa.size() * sizeof(float))) {
+            return false;
+        }
+    }
+    const std::vector<ms_agent_t> aa = agents(a);
+    const std::vector<ms_agent_t> ab = agents(b);
+    return aa.size() == ab.size() && same_bits(aa.data(), ab.data(), aa.size() * sizeof(ms_agent_t));
+}
+
+// Ohne Agenten laufen Gefahr-Pheromon und Molekuele in ms_step nur durch den Einzelschritt;
+// ms_fast_forward_field muss dasselbe Ergebnis liefern.
+void check_fast_forward(ms_field_precision precision) {
+    const ms_config_t cfg = make_config(97, 75, 0, 7);
+    ms_handle_t *single = ms_create(&cfg);
+    ms_set_field_precision(single, precision);
+    std::vector<float> seed_field = field(single, MS_FIELD_PHEROMONE_DANGER);
+    for (size_t i = 0; i < seed_field.size(); ++i) {
+        seed_field[i] = static_cast<float>((i * 7919u) % 257u) * 0.03125f;
+    }
+    ms_copy_field_in(single, MS_FIELD_PHEROMONE_DANGER, seed_field.data(), static_cast<int>(seed_field.size()));
+    ms_copy_field_in(single, MS_FIELD_MOLECULES, seed_field.data(), static_cast<int>(seed_field.size()));
+    ms_set_threads(single, 3);
+    ms_handle_t *blocked = ms_clone(single);
+
+    const int steps = 21;
+    ms_step(single, steps);
+    ms_fast_forward_field(blocked, MS_FIELD_PHEROMONE_DANGER, steps);
+    ms_fast_forward_field(blocked, MS_FIELD_MOLECULES, steps);
+    for (ms_field_kind kind : {MS_FIELD_PHEROMONE_DANGER, MS_FIELD_MOLECULES}) {
+        const std::vector<float> a = field(single, kind);
+        const std::vector<float> b = field(blocked, kind);
+        check(same_bits(a.data(), b.data(), a.size() * sizeof(float)),
+              precision == MS_PRECISION_FLOAT16 ? "fast forward fp16" : "fast forward fp32");
+    }
+    ms_destroy(single);
+    ms_destroy(blocked);
+}
+
+void check_threads(bool agent_parallel, ms_field_precision precision) {
+    const ms_config_t cfg = make_config(128, 96, 600, 42);
+    ms_handle_t *base = ms_create(&cfg);
+    ms_set_agent_parallel(base, agent_parallel ? 1 : 0);
+    ms_set_field_precision(base, precision);
+    ms_set_threads(base, 1);
+    ms_step(base, 60);
+    for (int threads : {3, 4}) {
+        ms_handle_t *h = ms_create(&cfg);
+        ms_set_agent_parallel(h, agent_parallel ? 1 : 0);
+        ms_set_field_precision(h, precision);
+        ms_set_threads(h, threads);
+        ms_step(h, 60);
+        check(same_state(base, h), agent_parallel ? "parallel agents: threads 1 vs 3/4" : "threads 1 vs 3/4");
+        ms_destroy(h);
+    }
+    ms_destroy(base);
+}
+
+void check_islands() {
+    ms_config_t cfg = make_config(64, 48, 200, 11);
+    cfg.params.evo_enable = 1;
+    cfg.params.evo_min_energy_to_store = 1.2f;
+    ms_islands_t *serial = ms_islands_create(&cfg, 4, 1);
+    ms_islands_t *threaded = ms_islands_create(&cfg, 4, 3);
+    ms_islands_set_migration(serial, 10, 4);
+    ms_islands_set_migration(threaded, 10, 4);
+    ms_islands_step(serial, 45);
+    ms_islands_step(threaded, 45);
+    for (int i = 0; i < ms_islands_count(serial); ++i) {
+        check(same_state(ms_islands_get(serial, i), ms_islands_get(threaded, i)), "islands: threads 1 vs 3");
+    }
+    ms_islands_destroy(serial);
+    ms_islands_destroy(threaded);
+}
+
+// Die geschlossene Form min(v + n * regen, max) weicht nur um Rundung vom wiederholten Addieren ab.
+void check_lazy_regen() {
+    ms_config_t cfg = make_config(96, 64, 0, 5);
+    cfg.params.resource_regen = 0.0013f;
+    ms_handle_t *eager = ms_create(&cfg);
+    ms_handle_t *lazy = ms_clone(eager);
+    ms_set_resource_lazy_regen(lazy, 1);
+    ms_step(eager, 40);
+    ms_step(lazy, 40);
+    const std::vector<float> a = field(eager, MS_FIELD_RESOURCES);
+    const std::vector<float> b = field(lazy, MS_FIELD_RESOURCES);
+    float worst = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i) {
+        worst = std::max(worst, std::fabs(a[i] - b[i]));
+    }
+    check(worst <= 1e-5f * cfg.params.resource_max, "lazy vs eager regen");
+    ms_destroy(eager);
+    ms_destroy(lazy);
+}
+
+void check_queries() {
+    const ms_config_t cfg = make_config(80, 60, 900, 3);
+    ms_handle_t *h = ms_create(&cfg);
+    ms_step(h, 15);
+    const std::vector<ms_agent_t> all = agents(h);
+    std::vector<int> ids(all.size());
+    for (int q = 0; q < 40; ++q) {
+        const float x = 0.37f + static_cast<float>((q * 13) % 80);
+        const float y = 0.11f + static_cast<float>((q * 29) % 60);
+        const float r = 0.5f + static_cast<float>(q % 9) * 1.75f;
+
+        std::vector<int> expect;
+        for (int i = 0; i < static_cast<int>(all.size()); ++i) {
+            if (all[i].x >= x - r && all[i].x < x + r && all[i].y >= y - r && all[i].y < y + r) {
+                expect.push_back(i);
+            }
+        }
+        int found = ms_query_agents_rect(h, x - r, y - r, x + r, y + r, ids.data(), static_cast<int>(ids.size()));
+        std::vector<int> got(ids.begin(), ids.begin() + found);
+        std::sort(got.begin(), got.end());
+        check(got == expect, "rect query vs brute force");
+
+        expect.clear();
+        for (int i = 0; i < static_cast<int>(all.size()); ++i) {
+            const float dx = all[i].x - x;
+            const float dy = all[i].y - y;
+            if (dx * dx + dy * dy <= r * r) {
+                expect.push_back(i);
+            }
+        }
+        found = ms_query_agents_radius(h, x, y, r, ids.data(), static_cast<int>(ids.size()));
+        got.assign(ids.begin(), ids.begin() + found);
+        std::sort(got.begin(), got.end());
+        check(got == expect, "radius query vs brute force");
+    }
+    ms_destroy(h);
+}
+
+} // namespace
+
+int main() {
+    check_fast_forward(MS_PRECISION_FLOAT32);
+    check_fast_forward(MS_PRECISION_FLOAT16);
+    check_threads(false, MS_PRECISION_FLOAT32);
+    check_threads(false, MS_PRECISION_FLOAT16);
+    check_threads(true, MS_PRECISION_FLOAT32);
+    check_islands();
+    check_lazy_regen();
+    check_queries();
+    if (failures > 0) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}